@@ -169,6 +169,59 @@ void tst_KActionCollection::readSettings()
     qDeleteAll(collection->actions());
 }
 
+void tst_KActionCollection::writeChangedSettingsOnly()
+{
+    KConfigGroup cfg = clearConfig();
+
+    const QList<QKeySequence> defaultShortcut{Qt::Key_A};
+    const QList<QKeySequence> temporaryShortcut{Qt::Key_C};
+
+    cfg.writeEntry("changed", QKeySequence::listToString(temporaryShortcut));
+    QAction *changed = new QAction(this);
+    KActionCollection::setDefaultShortcuts(changed, defaultShortcut);
+    collection->addAction(QStringLiteral("changed"), changed);
+
+    QAction *unchanged = new QAction(this);
+    KActionCollection::setDefaultShortcuts(unchanged, defaultShortcut);
+    collection->addAction(QStringLiteral("unchanged"), unchanged);
+
+    collection->readSettings(&cfg);
+    QCOMPARE(changed->shortcuts(), temporaryShortcut);
+
+    // Nothing changed since reading
+    collection->writeSettings(&cfg);
+    QCOMPARE(collection->writtenSettingsCount(), 0);
+
+    // Back to the default: the entry is removed
+    changed->setShortcuts(defaultShortcut);
+    collection->writeSettings(&cfg);
+    QCOMPARE(collection->writtenSettingsCount(), 1);
+    QVERIFY(!cfg.hasKey("changed"));
+
+    unchanged->setShortcuts(temporaryShortcut);
+    collection->writeSettings(&cfg);
+    QCOMPARE(collection->writtenSettingsCount(), 1);
+    QCOMPARE(cfg.readEntry("unchanged", QString()), QKeySequence::listToString(temporaryShortcut));
+    collection->writeSettings(&cfg);
+    QCOMPARE(collection->writtenSettingsCount(), 0);
+
+    // Another group doesn't have the entries yet
+    KConfigGroup otherCfg(cfg.config(), QStringLiteral("OtherShortcuts"));
+    collection->writeSettings(&otherCfg);
+    QCOMPARE(collection->writtenSettingsCount(), 1);
+    QCOMPARE(otherCfg.readEntry("unchanged", QString()), QKeySequence::listToString(temporaryShortcut));
+    otherCfg.deleteGroup();
+
+    // writeDefaults also writes the shortcuts which are the default
+    collection->writeSettings(&cfg, true);
+    QCOMPARE(collection->writtenSettingsCount(), 1);
+    QCOMPARE(cfg.readEntry("changed", QString()), QKeySequence::listToString(defaultShortcut));
+    collection->writeSettings(&cfg, true);
+    QCOMPARE(collection->writtenSettingsCount(), 0);
+
+    qDeleteAll(collection->actions());
+}
+
 void tst_KActionCollection::insertReplaces1()
 {
     QAction *a = new QAction(nullptr);
@@ -216,6 +269,35 @@ void tst_KActionCollection::insertReplaces2()
     delete a;
 }
 
+void tst_KActionCollection::writeUnchangedSettingsDoesNotSync()
+{
+    KConfigGroup cfg = clearConfig();
+    cfg.sync();
+
+    QAction *action = new QAction(this);
+    KActionCollection::setDefaultShortcut(action, QKeySequence(Qt::Key_A));
+    collection->addAction(QStringLiteral("action"), action);
+    collection->readSettings(&cfg);
+
+    // A pending change of another group is not flushed by an unchanged collection
+    KConfigGroup otherCfg(cfg.config(), QStringLiteral("OtherGroup"));
+    otherCfg.writeEntry("pending", true);
+    QVERIFY(cfg.config()->isDirty());
+    collection->writeSettings(&cfg);
+    QCOMPARE(collection->writtenSettingsCount(), 0);
+    QVERIFY(cfg.config()->isDirty());
+
+    // Once an entry is written, the config is synced
+    action->setShortcut(QKeySequence(Qt::Key_B));
+    collection->writeSettings(&cfg);
+    QCOMPARE(collection->writtenSettingsCount(), 1);
+    QVERIFY(!cfg.config()->isDirty());
+
+    otherCfg.deleteGroup();
+    cfg.sync();
+    qDeleteAll(collection->actions());
+}
+
 KConfigGroup tst_KActionCollection::clearConfig()
 {
     KSharedConfig::Ptr cfg = KSharedConfig::openConfig();
@@ -340,6 +422,64 @@ void tst_KActionCollection::testActionForName()
     delete c;
 }
 
+void tst_KActionCollection::testManyActions()
+{
+    const int count = 10000;
+    QList<QAction *> added;
+    for (int i = 0; i < count; ++i) {
+        added.append(collection->addAction(QStringLiteral("action_%1").arg(i)));
+    }
+    QCOMPARE(collection->count(), count);
+    QCOMPARE(collection->actions(), added);
+
+    // Remove every other action, the remaining ones must keep their order
+    QList<QAction *> expected;
+    for (int i = 0; i < count; ++i) {
+        if (i % 2) {
+            delete added.at(i);
+        } else {
+            expected.append(added.at(i));
+        }
+    }
+    QCOMPARE(collection->count(), count / 2);
+    QCOMPARE(collection->actions(), expected);
+    QVERIFY(!collection->action(QStringLiteral("action_1")));
+    QCOMPARE(collection->action(QStringLiteral("action_9998")), expected.last());
+
+    // Re-adding under a freed name appends at the end
+    QAction *readded = collection->addAction(QStringLiteral("action_1"));
+    QCOMPARE(collection->actions().last(), readded);
+    QCOMPARE(collection->action(QStringLiteral("action_1")), readded);
+    QCOMPARE(collection->action(QStringLiteral("action_0")), expected.first());
+
+    collection->clear();
+    QVERIFY(collection->isEmpty());
+}
+
+void tst_KActionCollection::benchmarkActionLookup()
+{
+    const int count = 10000;
+    QStringList names;
+    names.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        names.append(QStringLiteral("action_%1").arg(i));
+        collection->addAction(names.last());
+    }
+
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (const QString &name : std::as_const(names)) {
+            if (collection->action(name)) {
+                ++found;
+            }
+        }
+    }
+    QCOMPARE(found, count);
+
+    collection->clear();
+}
+
 QTEST_MAIN(tst_KActionCollection)
 
 #include "moc_kactioncollectiontest.cpp"
@@ -18,6 +18,8 @@ private Q_SLOTS:
     void take();
     void writeSettings();
     void readSettings();
+    void writeChangedSettingsOnly();
+    void writeUnchangedSettingsDoesNotSync();
     void insertReplaces1();
     void insertReplaces2();
     void testSetShortcuts();
@@ -27,6 +29,8 @@ private Q_SLOTS:
     void addStandardActionFunctorSignal();
     void testActionsAreInInsertionOrder();
     void testActionForName();
+    void testManyActions();
+    void benchmarkActionLookup();
 
 private:
     KConfigGroup clearConfig();
@@ -17,6 +17,7 @@
 #include <QSignalSpy>
 #include <QStandardPaths>
 #include <QTest>
+#include <QToolButton>
 
 #include <KConfig>
 #include <KConfigGroup>
@@ -58,9 +59,12 @@ private Q_SLOTS:
     void testToolButtonStyleNoXmlGui();
     void testToolButtonStyleXmlGui_data();
     void testToolButtonStyleXmlGui();
+    void testGlobalStyleSettings();
     void testToolBarPosition();
     void testXmlGuiSwitching();
     void testKAuthorizedDisableToggleAction();
+    void testSeparatorVisibility();
+    void testEditableMouseRedirection();
 
 Q_SIGNALS:
     void signalAppearanceChanged();
@@ -420,6 +424,38 @@ void tst_KToolBar::testToolButtonStyleXmlGui()
     }
 }
 
+void tst_KToolBar::testGlobalStyleSettings()
+{
+    {
+        KMainWindow kmw1;
+        KMainWindow kmw2;
+        KToolBar *toolBar1 = kmw1.toolBar(QStringLiteral("mainToolBar"));
+        KToolBar *toolBar2 = kmw2.toolBar(QStringLiteral("mainToolBar"));
+        QCOMPARE((int)toolBar1->toolButtonStyle(), (int)Qt::ToolButtonTextBesideIcon);
+        QCOMPARE((int)toolBar2->toolButtonStyle(), (int)Qt::ToolButtonTextBesideIcon);
+
+        // The toolbars share the KDE-global settings, a change applies to all of them
+        KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
+        group.writeEntry("ToolButtonStyle", QStringLiteral("IconOnly"));
+        Q_EMIT KIconLoader::global()->iconLoaderSettingsChanged();
+        QCOMPARE((int)toolBar1->toolButtonStyle(), (int)Qt::ToolButtonIconOnly);
+        QCOMPARE((int)toolBar2->toolButtonStyle(), (int)Qt::ToolButtonIconOnly);
+
+#ifdef WITH_QTDBUS // the change notification uses DBus
+        group.writeEntry("ToolButtonStyle", QStringLiteral("TextOnly"), KConfig::Notify);
+        group.sync();
+        QTRY_COMPARE((int)toolBar1->toolButtonStyle(), (int)Qt::ToolButtonTextOnly);
+        QTRY_COMPARE((int)toolBar2->toolButtonStyle(), (int)Qt::ToolButtonTextOnly);
+#endif
+    }
+
+    // Once the last toolbar is gone, the settings are read again for the next one
+    KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
+    group.writeEntry("ToolButtonStyle", QStringLiteral("TextUnderIcon"));
+    KMainWindow kmw;
+    QCOMPARE((int)kmw.toolBar(QStringLiteral("mainToolBar"))->toolButtonStyle(), (int)Qt::ToolButtonTextUnderIcon);
+}
+
 void tst_KToolBar::changeGlobalToolButtonStyleSetting(const QString &mainToolBar, const QString &otherToolBars)
 {
     KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
@@ -578,6 +614,59 @@ void tst_KToolBar::testKAuthorizedDisableToggleAction()
     }
 }
 
+void tst_KToolBar::testSeparatorVisibility()
+{
+    KMainWindow kmw;
+    KToolBar bar(&kmw);
+
+    QAction *leading = bar.addSeparator();
+    QAction *first = bar.addAction(QStringLiteral("first"));
+    QAction *middle = bar.addSeparator();
+    QAction *doubled = bar.addSeparator();
+    QAction *second = bar.addAction(QStringLiteral("second"));
+    QAction *trailing = bar.addSeparator();
+
+    // The separators are adjusted once for all the changes, when the event loop runs
+    QTRY_VERIFY(!leading->isVisible());
+    QVERIFY(middle->isVisible());
+    QVERIFY(!doubled->isVisible());
+    QVERIFY(!trailing->isVisible());
+
+    // No separator is needed after the last visible action
+    second->setVisible(false);
+    QTRY_VERIFY(!middle->isVisible());
+    QVERIFY(first->isVisible());
+
+    second->setVisible(true);
+    QTRY_VERIFY(middle->isVisible());
+
+    // Nor before the first one
+    bar.removeAction(first);
+    QTRY_VERIFY(!middle->isVisible());
+    QVERIFY(!leading->isVisible());
+}
+
+void tst_KToolBar::testEditableMouseRedirection()
+{
+    KMainWindow kmw;
+    KToolBar bar(&kmw);
+    QAction *action = bar.addAction(QStringLiteral("action"));
+    QToolButton *button = qobject_cast<QToolButton *>(bar.widgetForAction(action));
+    QVERIFY(button);
+
+    // While editing, the toolbar gets the mouse events of its buttons, to drag them around
+    KToolBar::setToolBarsEditable(true);
+    QTest::mousePress(button, Qt::LeftButton);
+    QVERIFY(!button->isDown());
+    QTest::mouseRelease(button, Qt::LeftButton);
+
+    KToolBar::setToolBarsEditable(false);
+    QTest::mousePress(button, Qt::LeftButton);
+    QVERIFY(button->isDown());
+    QTest::mouseRelease(button, Qt::LeftButton);
+    QVERIFY(!button->isDown());
+}
+
 bool tst_KToolBar::eventFilter(QObject *watched, QEvent *event)
 {
     Q_UNUSED(watched);
@@ -0,0 +1,470 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+// Benchmarks for the different steps of building a GUI from xmlgui files.
+// This is not part of the test suite, run it manually, e.g.
+//   ./kxmlgui_benchmark benchmarkCreateGUI
+// The on-disk document cache is disabled in test mode, run with
+// KXMLGUI_DOCUMENT_CACHE=1 to measure with it (the first iteration is cold).
+
+#include "testguiclient.h"
+#include "testxmlguiwindow.h"
+
+#include <QAction>
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <kedittoolbar.h>
+#include <kmainwindow.h>
+#include <ktoolbar.h>
+#include <kxmlguibuilder.h>
+
+#include <memory>
+#include <vector>
+
+static void enableTestMode()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+Q_CONSTRUCTOR_FUNCTION(enableTestMode)
+
+static const int s_topLevelMenus = 10;
+
+static QString actionName(const QString &prefix, int i)
+{
+    return prefix + QLatin1String("action_") + QString::number(i);
+}
+
+static QStringList actionNames(const QString &prefix, int count)
+{
+    QStringList names;
+    names.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        names.append(actionName(prefix, i));
+    }
+    return names;
+}
+
+// Generates a document with s_topLevelMenus menus, each with a chain of
+// depth nested submenus. The actions are spread over all these menus, and
+// every menu defines mergePoints groups (plus a <Merge/>) for child clients.
+static QByteArray generateXml(const QString &prefix, int actionCount, int depth, int mergePoints)
+{
+    const int menuCount = s_topLevelMenus * depth;
+    QList<QStringList> menuActions(menuCount);
+    for (int i = 0; i < actionCount; ++i) {
+        menuActions[i % menuCount].append(actionName(prefix, i));
+    }
+
+    QByteArray xml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"benchmark\" >\n"
+        "<MenuBar>\n";
+    for (int menu = 0; menu < s_topLevelMenus; ++menu) {
+        for (int level = 0; level < depth; ++level) {
+            const QStringList &actions = menuActions.at(menu * depth + level);
+            xml += "<Menu name=\"menu" + QByteArray::number(menu) + "_" + QByteArray::number(level) + "\"><text>Menu</text>\n";
+            int group = 0;
+            for (int i = 0; i < actions.size(); ++i) {
+                if (group < mergePoints && i % qMax(1, actions.size() / mergePoints) == 0) {
+                    xml += "<DefineGroup name=\"group_" + QByteArray::number(group++) + "\"/>\n";
+                }
+                xml += "<Action name=\"" + actions.at(i).toLatin1() + "\"/>\n";
+            }
+            xml += "<Merge/>\n";
+        }
+        for (int level = 0; level < depth; ++level) {
+            xml += "</Menu>\n";
+        }
+    }
+    xml += "</MenuBar>\n<ToolBar name=\"mainToolBar\"><text>Main Toolbar</text>\n";
+    for (int i = 0; i < qMin(actionCount, 30); ++i) {
+        xml += "<Action name=\"" + actionName(prefix, i).toLatin1() + "\"/>\n";
+    }
+    xml += "<Merge/>\n</ToolBar>\n</gui>\n";
+    return xml;
+}
+
+// A child client merging actionCount actions into the toplevel menus
+// (and their groups) of a document created by generateXml()
+static QByteArray generateChildXml(const QString &prefix, int actionCount, int mergePoints)
+{
+    QByteArray xml =
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\""
+        + prefix.toLatin1() + "\" >\n<MenuBar>\n";
+    for (int menu = 0; menu < s_topLevelMenus; ++menu) {
+        xml += "<Menu name=\"menu" + QByteArray::number(menu) + "_0\">\n";
+        for (int i = menu; i < actionCount; i += s_topLevelMenus) {
+            xml += "<Action name=\"" + actionName(prefix, i).toLatin1() + "\"";
+            if (mergePoints > 0) {
+                xml += " group=\"group_" + QByteArray::number(i % mergePoints) + "\"";
+            }
+            xml += "/>\n";
+        }
+        xml += "</Menu>\n";
+    }
+    xml += "</MenuBar>\n<ToolBar name=\"mainToolBar\">\n<Action name=\"" + actionName(prefix, 0).toLatin1() + "\"/>\n</ToolBar>\n</gui>\n";
+    return xml;
+}
+
+// A child client defining groupCount groups of its own inside the groups of
+// the first menu of a document created by generateXml(), so that its merging
+// indices get inserted between the existing ones
+static QByteArray generateNestedGroupsXml(const QString &prefix, int groupCount, int mergePoints)
+{
+    QByteArray xml =
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\""
+        + prefix.toLatin1() + "\" >\n<MenuBar>\n<Menu name=\"menu0_0\">\n";
+    for (int i = 0; i < groupCount; ++i) {
+        xml += "<DefineGroup name=\"" + prefix.toLatin1() + "group_" + QByteArray::number(i) + "\" group=\"group_"
+            + QByteArray::number(i % mergePoints) + "\"/>\n";
+    }
+    xml += "</Menu>\n</MenuBar>\n</gui>\n";
+    return xml;
+}
+
+static QDomDocument parse(const QByteArray &xml)
+{
+    QDomDocument doc;
+    doc.setContent(xml);
+    return doc;
+}
+
+// Runs f rounds times and reports the average wall time spent in it
+template<typename Setup, typename F, typename Teardown>
+static void measure(int rounds, Setup setup, F f, Teardown teardown)
+{
+    QElapsedTimer timer;
+    qint64 total = 0;
+    for (int i = 0; i < rounds; ++i) {
+        setup();
+        timer.start();
+        f();
+        total += timer.nsecsElapsed();
+        teardown();
+    }
+    QTest::setBenchmarkResult(qreal(total) / rounds / 1000000, QTest::WalltimeMilliseconds);
+}
+
+class KXmlGui_Benchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkSetXMLFile_data();
+    void benchmarkSetXMLFile();
+    void benchmarkMergeXML_data();
+    void benchmarkMergeXML();
+    void benchmarkAddClient_data();
+    void benchmarkAddClient();
+    void benchmarkRemoveClient_data();
+    void benchmarkRemoveClient();
+    void benchmarkCreateGUI_data();
+    void benchmarkCreateGUI();
+    void benchmarkMergePoints_data();
+    void benchmarkMergePoints();
+    void benchmarkEditToolBarLoading_data();
+    void benchmarkEditToolBarLoading();
+    void benchmarkToolBarFilling_data();
+    void benchmarkToolBarFilling();
+
+private:
+    void sizes();
+    void childClients();
+
+    QTemporaryDir m_dir;
+};
+
+QTEST_MAIN(KXmlGui_Benchmark)
+
+void KXmlGui_Benchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void KXmlGui_Benchmark::sizes()
+{
+    QTest::addColumn<int>("actionCount");
+    QTest::addColumn<int>("depth");
+    QTest::addColumn<int>("mergePoints");
+
+    QTest::newRow("100 actions") << 100 << 1 << 1;
+    QTest::newRow("1k actions") << 1000 << 1 << 1;
+    QTest::newRow("10k actions") << 10000 << 1 << 1;
+    QTest::newRow("1k actions, deep menus") << 1000 << 20 << 1;
+    QTest::newRow("1k actions, many merge points") << 1000 << 1 << 50;
+}
+
+void KXmlGui_Benchmark::childClients()
+{
+    QTest::addColumn<int>("actionCount");
+    QTest::addColumn<int>("mergePoints");
+    QTest::addColumn<int>("childCount");
+
+    QTest::newRow("no children") << 1000 << 10 << 0;
+    QTest::newRow("10 children") << 1000 << 10 << 10;
+    QTest::newRow("50 children") << 1000 << 10 << 50;
+    QTest::newRow("50 children, no groups") << 1000 << 0 << 50;
+}
+
+void KXmlGui_Benchmark::benchmarkSetXMLFile_data()
+{
+    sizes();
+}
+
+void KXmlGui_Benchmark::benchmarkSetXMLFile()
+{
+    QFETCH(int, actionCount);
+    QFETCH(int, depth);
+    QFETCH(int, mergePoints);
+
+    QFile file(m_dir.filePath(QStringLiteral("setxmlfile.rc")));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(generateXml(QString(), actionCount, depth, mergePoints));
+    file.close();
+
+    TestGuiClient client;
+    client.createActions(actionNames(QString(), actionCount));
+    QBENCHMARK {
+        client.setXMLFilePublic(file.fileName());
+    }
+    QVERIFY(!client.domDocument().documentElement().isNull());
+}
+
+void KXmlGui_Benchmark::benchmarkMergeXML_data()
+{
+    sizes();
+}
+
+void KXmlGui_Benchmark::benchmarkMergeXML()
+{
+    QFETCH(int, actionCount);
+    QFETCH(int, depth);
+    QFETCH(int, mergePoints);
+
+    const QDomDocument standards = parse(KXMLGUIFactory::readConfigFile(KXMLGUIClient::standardsXmlFileLocation()).toUtf8());
+    const QDomDocument doc = parse(generateXml(QString(), actionCount, depth, mergePoints));
+
+    TestGuiClient client;
+    client.createActions(actionNames(QString(), actionCount));
+    // mergeXML modifies both documents, so each round merges fresh copies
+    QDomDocument base;
+    QDomDocument additive;
+    measure(
+        10,
+        [&] {
+            base = standards.cloneNode(true).toDocument();
+            additive = doc.cloneNode(true).toDocument();
+            client.setDOMDocumentPublic(base);
+        },
+        [&] {
+            client.setDOMDocumentPublic(additive, true);
+        },
+        [] {});
+}
+
+void KXmlGui_Benchmark::benchmarkAddClient_data()
+{
+    childClients();
+}
+
+void KXmlGui_Benchmark::benchmarkAddClient()
+{
+    QFETCH(int, actionCount);
+    QFETCH(int, mergePoints);
+    QFETCH(int, childCount);
+
+    TestGuiClient host;
+    host.createActions(actionNames(QString(), actionCount));
+    host.setDOMDocumentPublic(parse(generateXml(QString(), actionCount, 1, mergePoints)));
+    std::vector<std::unique_ptr<TestGuiClient>> children;
+    for (int i = 0; i < childCount; ++i) {
+        const QString prefix = QStringLiteral("child%1_").arg(i);
+        auto child = std::make_unique<TestGuiClient>(&host);
+        child->createActions(actionNames(prefix, 20));
+        child->setDOMDocumentPublic(parse(generateChildXml(prefix, 20, mergePoints)));
+        children.push_back(std::move(child));
+    }
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    measure(
+        10,
+        [] {},
+        [&] {
+            factory.addClient(&host);
+        },
+        [&] {
+            factory.removeClient(&host);
+        });
+}
+
+void KXmlGui_Benchmark::benchmarkRemoveClient_data()
+{
+    childClients();
+}
+
+void KXmlGui_Benchmark::benchmarkRemoveClient()
+{
+    QFETCH(int, actionCount);
+    QFETCH(int, mergePoints);
+    QFETCH(int, childCount);
+
+    TestGuiClient host;
+    host.createActions(actionNames(QString(), actionCount));
+    host.setDOMDocumentPublic(parse(generateXml(QString(), actionCount, 1, mergePoints)));
+    std::vector<std::unique_ptr<TestGuiClient>> children;
+    for (int i = 0; i < childCount; ++i) {
+        const QString prefix = QStringLiteral("child%1_").arg(i);
+        auto child = std::make_unique<TestGuiClient>(&host);
+        child->createActions(actionNames(prefix, 20));
+        child->setDOMDocumentPublic(parse(generateChildXml(prefix, 20, mergePoints)));
+        children.push_back(std::move(child));
+    }
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    measure(
+        10,
+        [&] {
+            factory.addClient(&host);
+        },
+        [&] {
+            factory.removeClient(&host);
+        },
+        [] {});
+}
+
+void KXmlGui_Benchmark::benchmarkCreateGUI_data()
+{
+    sizes();
+}
+
+void KXmlGui_Benchmark::benchmarkCreateGUI()
+{
+    QFETCH(int, actionCount);
+    QFETCH(int, depth);
+    QFETCH(int, mergePoints);
+
+    TestXmlGuiWindow mainWindow(generateXml(QString(), actionCount, depth, mergePoints), "kxmlgui_benchmarkui.rc");
+    mainWindow.createActions(actionNames(QString(), actionCount));
+    QBENCHMARK {
+        mainWindow.createGUI();
+    }
+}
+
+void KXmlGui_Benchmark::benchmarkMergePoints_data()
+{
+    QTest::addColumn<int>("mergePoints");
+    QTest::addColumn<int>("childCount");
+
+    QTest::newRow("1k merge points") << 1000 << 0;
+    QTest::newRow("5k merge points") << 5000 << 0;
+    QTest::newRow("1k merge points, 10 children") << 1000 << 10;
+    QTest::newRow("5k merge points, 10 children") << 5000 << 10;
+}
+
+// Adding clients defining many merge points (in a single menu), and child
+// clients defining theirs in between
+void KXmlGui_Benchmark::benchmarkMergePoints()
+{
+    QFETCH(int, mergePoints);
+    QFETCH(int, childCount);
+
+    // one action per group, all in the first menu
+    const int actionCount = mergePoints * s_topLevelMenus;
+    TestGuiClient host;
+    host.createActions(actionNames(QString(), actionCount));
+    host.setDOMDocumentPublic(parse(generateXml(QString(), actionCount, 1, mergePoints)));
+    std::vector<std::unique_ptr<TestGuiClient>> children;
+    for (int i = 0; i < childCount; ++i) {
+        const QString prefix = QStringLiteral("child%1_").arg(i);
+        auto child = std::make_unique<TestGuiClient>(&host);
+        child->setDOMDocumentPublic(parse(generateNestedGroupsXml(prefix, mergePoints, mergePoints)));
+        children.push_back(std::move(child));
+    }
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    measure(
+        10,
+        [] {},
+        [&] {
+            factory.addClient(&host);
+        },
+        [&] {
+            factory.removeClient(&host);
+        });
+}
+
+void KXmlGui_Benchmark::benchmarkEditToolBarLoading_data()
+{
+    sizes();
+}
+
+void KXmlGui_Benchmark::benchmarkEditToolBarLoading()
+{
+    QFETCH(int, actionCount);
+    QFETCH(int, depth);
+    QFETCH(int, mergePoints);
+
+    TestXmlGuiWindow mainWindow(generateXml(QString(), actionCount, depth, mergePoints), "kxmlgui_benchmarkui.rc");
+    mainWindow.createActions(actionNames(QString(), actionCount));
+    mainWindow.createGUI();
+    QBENCHMARK {
+        // Loading happens when the dialog gets shown
+        KEditToolBar dialog(mainWindow.guiFactory());
+        dialog.show();
+        dialog.hide();
+    }
+}
+
+void KXmlGui_Benchmark::benchmarkToolBarFilling_data()
+{
+    QTest::addColumn<int>("actionCount");
+
+    QTest::newRow("30 actions") << 30;
+    QTest::newRow("300 actions") << 300;
+}
+
+// Refilling a toolbar, like applications with toolbars depending on the selection do
+void KXmlGui_Benchmark::benchmarkToolBarFilling()
+{
+    QFETCH(int, actionCount);
+
+    KMainWindow mainWindow;
+    KToolBar toolBar(&mainWindow);
+    QList<QAction *> actions;
+    for (int i = 0; i < actionCount; ++i) {
+        auto *action = new QAction(actionName(QString(), i), &toolBar);
+        action->setSeparator(i % 10 == 9);
+        actions.append(action);
+    }
+
+    QBENCHMARK {
+        toolBar.addActions(actions);
+        // includes the (deferred) adjustment of the separators
+        QCoreApplication::sendPostedEvents(&toolBar, QEvent::MetaCall);
+        toolBar.clear();
+        QCoreApplication::sendPostedEvents(&toolBar, QEvent::MetaCall);
+    }
+}
+
+#include "kxmlgui_benchmark.moc"
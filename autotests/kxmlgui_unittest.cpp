@@ -10,25 +10,39 @@
 #include "testxmlguiwindow.h"
 
 #include <QAction>
+#include <QDateTime>
 #include <QDebug>
 #include <QDialogButtonBox>
 #include <QDir>
+#include <QFuture>
 #include <QHBoxLayout>
+#include <QLineEdit>
 #include <QMenuBar>
+#include <QPointer>
 #include <QPushButton>
+#include <QRegularExpression>
+#include <QScopeGuard>
 #include <QShowEvent>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTest>
+#include <QTimeZone>
+#include <QTreeView>
 #include <QWidget>
 
 #include <KConfigGroup>
 #include <KSharedConfig>
 
 #include <kedittoolbar.h>
+#include <kshortcutseditor.h>
 #include <kswitchlanguagedialog_p.h>
 #include <kxmlguibuilder.h>
 #include <kxmlguiclient.h>
+#include <kshortcutindex.cpp> // not exported either
 #include <kxmlguiversionhandler.cpp> // it's not exported, so we need to include the code here
 
+#include <memory>
+
 QTEST_MAIN(KXmlGui_UnitTest)
 
 enum Flags {
@@ -163,6 +177,9 @@ void KXmlGui_UnitTest::testFindVersionNumber_data()
         "the same menu entries at the same place in KMail and Kontact  -->\n"
         "<gui version=\"452\" name=\"kmmainwin\">\n"
                                     << "452";
+    QTest::newRow("after a long comment") << // longer than what KXmlGuiVersionHandler reads at first
+        QLatin1String("<!DOCTYPE gui>\n<!-- %1 -->\n<gui version=\"7\" name=\"foo\"/>\n").arg(QString(5000, QLatin1Char('x')))
+                                          << "7";
 }
 
 void KXmlGui_UnitTest::testFindVersionNumber()
@@ -170,6 +187,36 @@ void KXmlGui_UnitTest::testFindVersionNumber()
     QFETCH(QString, xml);
     QFETCH(QString, version);
     QCOMPARE(KXMLGUIClient::findVersionNumber(xml), version);
+
+    // The byte based probe used by KXmlGuiVersionHandler must agree
+    QCOMPARE(QString::fromLatin1(findVersionNumber(xml.toUtf8())), version);
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(xml.toUtf8());
+    file.close();
+    QCOMPARE(QString::fromLatin1(probeVersionNumber(file.fileName())), version);
+}
+
+void KXmlGui_UnitTest::testReadConfigFile()
+{
+    // A file on disk (memory mapped), with non-ASCII text
+    const QString xml = QStringLiteral("<!DOCTYPE gui>\n<gui version=\"1\" name=\"foo\"><Menu name=\"file\"><text>Fi\u00e7hier</text></Menu></gui>\n");
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(xml.toUtf8());
+    file.close();
+    QCOMPARE(KXMLGUIFactory::readConfigFile(file.fileName()), xml);
+
+    // An empty file
+    QTemporaryFile emptyFile;
+    QVERIFY(emptyFile.open());
+    emptyFile.close();
+    QVERIFY(KXMLGUIFactory::readConfigFile(emptyFile.fileName()).isEmpty());
+
+    // A built-in resource, which may or may not be compressed
+    QFile resource(QStringLiteral(":/kxmlgui5/ui_standards.rc"));
+    QVERIFY(resource.open(QIODevice::ReadOnly));
+    QCOMPARE(KXMLGUIFactory::readConfigFile(resource.fileName()), QString::fromUtf8(resource.readAll()));
 }
 
 void KXmlGui_UnitTest::testVersionHandlerSameVersion()
@@ -536,6 +583,161 @@ void KXmlGui_UnitTest::testShortcutSchemeMerging()
     factory.removeClient(&client);
 }
 
+// Several clients merging into named merge points, groups and the default merge point of one menu
+void KXmlGui_UnitTest::testMergingIndices()
+{
+    const QByteArray hostXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"host\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"edit\"><text>&amp;Edit</text>\n"
+        "  <Action name=\"edit_undo\"/>\n"
+        "  <DefineGroup name=\"edit_paste_merge\"/>\n"
+        "  <Action name=\"edit_cut\"/>\n"
+        "  <Merge name=\"part\"/>\n"
+        "  <Separator/>\n"
+        "  <Merge/>\n"
+        "  <Action name=\"edit_find\"/>\n"
+        "  <DefineGroup name=\"edit_select_merge\"/>\n"
+        "  <DefineGroup name=\"edit_select_merge\"/>\n" // redefinitions are ignored
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "</gui>\n";
+    const QByteArray partXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"part\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"edit\"><text>&amp;Edit</text>\n"
+        "  <Action name=\"part_action\"/>\n"
+        "  <Action name=\"part_paste\" group=\"edit_paste_merge\"/>\n"
+        "  <Action name=\"part_select\" group=\"edit_select_merge\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "</gui>\n";
+    const QByteArray otherXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"other\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"edit\"><text>&amp;Edit</text>\n"
+        "  <Action name=\"other_action\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "</gui>\n";
+
+    TestGuiClient hostClient(hostXml);
+    hostClient.createActions(QStringList() << QStringLiteral("edit_undo") << QStringLiteral("edit_cut") << QStringLiteral("edit_find"));
+    TestGuiClient partClient(partXml);
+    partClient.createActions(QStringList() << QStringLiteral("part_action") << QStringLiteral("part_paste") << QStringLiteral("part_select"));
+    TestGuiClient otherClient(otherXml);
+    otherClient.createActions(QStringList() << QStringLiteral("other_action"));
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    factory.addClient(&hostClient);
+
+    QMenu *editMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("edit"), &hostClient));
+    QVERIFY(editMenu);
+    checkActions(editMenu->actions(),
+                 QStringList() << QStringLiteral("edit_undo") << QStringLiteral("edit_cut") << QStringLiteral("separator") << QStringLiteral("edit_find"));
+
+    factory.addClient(&partClient);
+    factory.addClient(&otherClient);
+    const QStringList expectedActions = QStringList() << QStringLiteral("edit_undo") << QStringLiteral("part_paste") << QStringLiteral("edit_cut")
+                                                      << QStringLiteral("part_action") << QStringLiteral("separator") << QStringLiteral("other_action")
+                                                      << QStringLiteral("edit_find") << QStringLiteral("part_select");
+    checkActions(editMenu->actions(), expectedActions);
+
+    // Removing a client in the middle shifts the merging indices back...
+    factory.removeClient(&partClient);
+    checkActions(editMenu->actions(),
+                 QStringList() << QStringLiteral("edit_undo") << QStringLiteral("edit_cut") << QStringLiteral("separator") << QStringLiteral("other_action")
+                               << QStringLiteral("edit_find"));
+
+    // ...so that adding it again puts everything at the same place
+    factory.addClient(&partClient);
+    checkActions(editMenu->actions(), expectedActions);
+
+    factory.removeClient(&otherClient);
+    factory.removeClient(&partClient);
+    checkActions(editMenu->actions(),
+                 QStringList() << QStringLiteral("edit_undo") << QStringLiteral("edit_cut") << QStringLiteral("separator") << QStringLiteral("edit_find"));
+    factory.removeClient(&hostClient);
+}
+
+// Records what the factory asks it to create
+class TagRecordingBuilder : public KXMLGUIBuilder
+{
+public:
+    using KXMLGUIBuilder::KXMLGUIBuilder;
+
+    QStringList customTags() const override
+    {
+        return KXMLGUIBuilder::customTags() + extraCustomTags;
+    }
+    QStringList containerTags() const override
+    {
+        return KXMLGUIBuilder::containerTags() + extraContainerTags;
+    }
+    QWidget *createContainer(QWidget *parent, int index, const QDomElement &element, QAction *&containerAction) override
+    {
+        createdContainers.append(element.tagName());
+        return KXMLGUIBuilder::createContainer(parent, index, element, containerAction);
+    }
+    QAction *createCustomElement(QWidget *parent, int index, const QDomElement &element) override
+    {
+        createdCustomElements.append(element.tagName());
+        return KXMLGUIBuilder::createCustomElement(parent, index, element);
+    }
+
+    QStringList extraCustomTags;
+    QStringList extraContainerTags;
+    QStringList createdContainers;
+    QStringList createdCustomElements;
+};
+
+void KXmlGui_UnitTest::testTagKinds()
+{
+    const QByteArray xml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"tags\" >\n"
+        "<Box name=\"box\"/>\n"
+        "<label/>\n"
+        "<Panel name=\"panel\"/>\n"
+        "<Merge/>\n"
+        "</gui>\n";
+
+    KMainWindow mainWindow;
+    TagRecordingBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    TagRecordingBuilder clientBuilder(&mainWindow);
+    TestGuiClient client(xml);
+    client.setClientBuilder(&clientBuilder);
+
+    // Custom tags win over container tags, which win over the built-in tags,
+    // all of them case insensitive
+    clientBuilder.extraCustomTags = QStringList{QStringLiteral("Box"), QStringLiteral("Label")};
+    clientBuilder.extraContainerTags = QStringList{QStringLiteral("Box"), QStringLiteral("Panel"), QStringLiteral("Merge")};
+    factory.addClient(&client);
+    QCOMPARE(clientBuilder.createdContainers, (QStringList{QStringLiteral("Panel"), QStringLiteral("Merge")}));
+    QCOMPARE(builder.createdCustomElements, (QStringList{QStringLiteral("Box"), QStringLiteral("label")}));
+    factory.removeClient(&client);
+
+    // The tags of the same builder are asked for again on the next build
+    clientBuilder.extraCustomTags = QStringList{QStringLiteral("Label")};
+    clientBuilder.extraContainerTags = QStringList{QStringLiteral("Box"), QStringLiteral("Panel")};
+    clientBuilder.createdContainers.clear();
+    builder.createdCustomElements.clear();
+    factory.addClient(&client);
+    QCOMPARE(clientBuilder.createdContainers, (QStringList{QStringLiteral("Box"), QStringLiteral("Panel")}));
+    QCOMPARE(builder.createdCustomElements, QStringList{QStringLiteral("label")});
+    factory.removeClient(&client);
+}
+
 void KXmlGui_UnitTest::testPartMergingSettings() // #252911
 {
     const QByteArray hostXml =
@@ -624,6 +826,11 @@ void KXmlGui_UnitTest::testUiStandardsMerging_data()
         << QByteArray(xmlBegin + "<Menu name=\"foo\"><Action name=\"foo_action\"/></Menu>\n" + xmlEnd)
         << (QStringList() << QStringLiteral("file_open") << QStringLiteral("options_configure_toolbars") << QStringLiteral("foo_action"))
         << (QStringList() << QStringLiteral("file") << QStringLiteral("foo") << QStringLiteral("settings"));
+    QTest::newRow("foo menu defined twice")
+        << QByteArray(xmlBegin + "<Menu name=\"foo\"><Action name=\"foo_action\"/></Menu>\n"
+                      + "<Menu name=\"foo\"><Action name=\"foo_action\"/></Menu>\n" + xmlEnd)
+        << (QStringList() << QStringLiteral("file_open") << QStringLiteral("options_configure_toolbars") << QStringLiteral("foo_action"))
+        << (QStringList() << QStringLiteral("file") << QStringLiteral("foo") << QStringLiteral("settings"));
 
     QTest::newRow("Bille's testcase: menu patch + menu edit")
         << QByteArray(xmlBegin + "<Menu name=\"patch\"><Action name=\"patch_generate\"/></Menu>\n"
@@ -784,6 +991,86 @@ void KXmlGui_UnitTest::testActionListAndSeparator()
     factory.removeClient(&client);
 }
 
+static QList<QAction *> createActions(const QStringList &names, QObject *parent)
+{
+    QList<QAction *> actions;
+    for (const QString &name : names) {
+        QAction *action = new QAction(name, parent);
+        action->setObjectName(name);
+        actions.append(action);
+    }
+    return actions;
+}
+
+void KXmlGui_UnitTest::testActionListOrdering()
+{
+    const QByteArray hostXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"host\" >\n"
+        "<ToolBar name=\"mainToolBar\">\n"
+        "  <Action name=\"go_up\"/>\n"
+        "  <ActionList name=\"first_list\"/>\n"
+        "  <Merge/>\n"
+        "  <Action name=\"go_back\"/>\n"
+        "  <ActionList name=\"second_list\"/>\n"
+        "  <Action name=\"go_home\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+    const QByteArray partXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"part\" >\n"
+        "<ToolBar name=\"mainToolBar\">\n"
+        "  <Action name=\"part_action\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+
+    TestGuiClient hostClient(hostXml);
+    hostClient.createActions(QStringList() << QStringLiteral("go_up") << QStringLiteral("go_back") << QStringLiteral("go_home"));
+    TestGuiClient partClient(partXml);
+    partClient.createActions(QStringList() << QStringLiteral("part_action"));
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    factory.addClient(&hostClient);
+    factory.addClient(&partClient);
+
+    KToolBar *toolBar = hostClient.toolBarByName(QStringLiteral("mainToolBar"));
+    checkActions(toolBar->actions(),
+                 QStringList() << QStringLiteral("go_up") << QStringLiteral("part_action") << QStringLiteral("go_back") << QStringLiteral("go_home"));
+
+    // A list plugged before the merged actions of the part must shift all following merging indices
+    hostClient.plugActionList(QStringLiteral("second_list"), createActions({QStringLiteral("s1"), QStringLiteral("s2"), QStringLiteral("s3")}, this));
+    hostClient.plugActionList(QStringLiteral("first_list"), createActions({QStringLiteral("f1"), QStringLiteral("f2")}, this));
+    checkActions(toolBar->actions(),
+                 QStringList() << QStringLiteral("go_up") << QStringLiteral("f1") << QStringLiteral("f2") << QStringLiteral("part_action")
+                               << QStringLiteral("go_back") << QStringLiteral("s1") << QStringLiteral("s2") << QStringLiteral("s3")
+                               << QStringLiteral("go_home"));
+    for (QAction *action : toolBar->actions()) {
+        QVERIFY(toolBar->widgetForAction(action));
+    }
+
+    // Replugging with a different size keeps everything else in place
+    hostClient.unplugActionList(QStringLiteral("first_list"));
+    hostClient.plugActionList(QStringLiteral("first_list"), createActions({QStringLiteral("g1"), QStringLiteral("g2"), QStringLiteral("g3")}, this));
+    hostClient.unplugActionList(QStringLiteral("second_list"));
+    hostClient.plugActionList(QStringLiteral("second_list"), {});
+    checkActions(toolBar->actions(),
+                 QStringList() << QStringLiteral("go_up") << QStringLiteral("g1") << QStringLiteral("g2") << QStringLiteral("g3")
+                               << QStringLiteral("part_action") << QStringLiteral("go_back") << QStringLiteral("go_home"));
+
+    // And the merging indices are still right for new clients
+    factory.removeClient(&partClient);
+    factory.addClient(&partClient);
+    checkActions(toolBar->actions(),
+                 QStringList() << QStringLiteral("go_up") << QStringLiteral("g1") << QStringLiteral("g2") << QStringLiteral("g3")
+                               << QStringLiteral("part_action") << QStringLiteral("go_back") << QStringLiteral("go_home"));
+
+    factory.removeClient(&partClient);
+    factory.removeClient(&hostClient);
+}
+
 void KXmlGui_UnitTest::testHiddenToolBar()
 {
     const QByteArray xml =
@@ -828,6 +1115,52 @@ void KXmlGui_UnitTest::testHiddenToolBar()
     mainWindow.close();
 }
 
+void KXmlGui_UnitTest::testToolBarStateAfterRemoval()
+{
+    const QByteArray xml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" >\n"
+        "<ToolBar name=\"partToolBar\">\n"
+        "  <text>Part Toolbar</text>\n"
+        "  <Action name=\"go_up\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    TestGuiClient client(xml);
+    client.createActions(QStringList() << QStringLiteral("go_up"));
+    const QString originalXml = client.domDocument().toString();
+
+    factory.addClient(&client);
+    KToolBar *toolBar = client.toolBarByName(QStringLiteral("partToolBar"));
+    mainWindow.addToolBar(Qt::LeftToolBarArea, toolBar);
+    toolBar->hide();
+
+    // Removing the client saves the toolbar state, without touching (or copying) its document
+    factory.removeClient(&client);
+    QVERIFY(client.xmlguiBuildDocument().isNull());
+    QCOMPARE(client.domDocument().toString(), originalXml);
+
+    // ...and adding it again restores it
+    factory.addClient(&client);
+    toolBar = client.toolBarByName(QStringLiteral("partToolBar"));
+    QVERIFY(toolBar->isHidden());
+    QCOMPARE(mainWindow.toolBarArea(toolBar), Qt::LeftToolBarArea);
+    QCOMPARE(toolBar->windowTitle(), QStringLiteral("Part Toolbar"));
+
+    // A new document forgets about the state
+    factory.removeClient(&client);
+    client.replaceXML(xml);
+    factory.addClient(&client);
+    toolBar = client.toolBarByName(QStringLiteral("partToolBar"));
+    QVERIFY(!toolBar->isHidden());
+
+    factory.removeClient(&client);
+}
+
 void KXmlGui_UnitTest::testCustomPlaceToolBar()
 {
     const QByteArray xml =
@@ -1007,6 +1340,385 @@ void KXmlGui_UnitTest::testDeletedContainers() // deleted="true"
     mainWindow.close();
 }
 
+void KXmlGui_UnitTest::testUpdateClients()
+{
+    const QByteArray xml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"file_new\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "<ToolBar name=\"mainToolBar\">\n"
+        "  <Action name=\"go_up\"/>\n"
+        "  <Action name=\"go_back\"/>\n"
+        "</ToolBar>\n"
+        "<ToolBar name=\"otherToolBar\">\n"
+        "  <Action name=\"go_home\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+
+    TestGuiClient client(xml);
+    client.createActions(QStringList() << QStringLiteral("go_up") << QStringLiteral("go_back") << QStringLiteral("go_forward") << QStringLiteral("go_home")
+                                       << QStringLiteral("file_new"));
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    factory.addClient(&client);
+
+    KToolBar *mainToolBar = client.toolBarByName(QStringLiteral("mainToolBar"));
+    KToolBar *otherToolBar = client.toolBarByName(QStringLiteral("otherToolBar"));
+    QWidget *fileMenu = factory.container(QStringLiteral("file"), &client);
+    QVERIFY(fileMenu);
+    QWidget *goUpButton = mainToolBar->widgetForAction(client.action("go_up"));
+    QVERIFY(goUpButton);
+
+    // Only otherToolBar changed, it gets refilled in place and nothing else is touched
+    const QByteArray changedXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"file_new\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "<ToolBar name=\"mainToolBar\">\n"
+        "  <Action name=\"go_up\"/>\n"
+        "  <Action name=\"go_back\"/>\n"
+        "</ToolBar>\n"
+        "<ToolBar name=\"otherToolBar\">\n"
+        "  <Action name=\"go_home\"/>\n"
+        "  <Separator/>\n"
+        "  <Action name=\"go_forward\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+    client.replaceXML(changedXml);
+    factory.updateClients({&client});
+
+    QCOMPARE(client.toolBarByName(QStringLiteral("mainToolBar")), mainToolBar);
+    QCOMPARE(mainToolBar->widgetForAction(client.action("go_up")), goUpButton);
+    QCOMPARE(client.toolBarByName(QStringLiteral("otherToolBar")), otherToolBar);
+    checkActions(otherToolBar->actions(), QStringList() << QStringLiteral("go_home") << QStringLiteral("separator") << QStringLiteral("go_forward"));
+    QCOMPARE(factory.container(QStringLiteral("file"), &client), fileMenu);
+
+    // Setting the same XML again is a no-op
+    client.replaceXML(changedXml);
+    factory.updateClients({&client});
+    QCOMPARE(mainToolBar->widgetForAction(client.action("go_up")), goUpButton);
+    checkActions(otherToolBar->actions(), QStringList() << QStringLiteral("go_home") << QStringLiteral("separator") << QStringLiteral("go_forward"));
+
+    // A container dropped from the XML is removed, the old document is used to tear it down
+    const QByteArray droppedToolBarXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"file_new\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "<ToolBar name=\"mainToolBar\">\n"
+        "  <Action name=\"go_up\"/>\n"
+        "  <Action name=\"go_back\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+    client.replaceXML(droppedToolBarXml);
+    const QString droppedToolBarDoc = client.domDocument().toString();
+    QPointer<KToolBar> droppedToolBar = otherToolBar;
+    factory.updateClients({&client});
+    QVERIFY(!droppedToolBar);
+    QVERIFY(!factory.container(QStringLiteral("otherToolBar"), &client));
+    mainToolBar = client.toolBarByName(QStringLiteral("mainToolBar"));
+    checkActions(mainToolBar->actions(), QStringList() << QStringLiteral("go_up") << QStringLiteral("go_back"));
+    QVERIFY(factory.container(QStringLiteral("file"), &client));
+    QCOMPARE(client.domDocument().toString(), droppedToolBarDoc);
+
+    // Changes made to the document in place can't be compared, the client is rebuilt
+    QDomDocument doc = client.domDocument();
+    QDomElement mainToolBarElement = doc.documentElement().lastChildElement(QStringLiteral("ToolBar"));
+    QCOMPARE(mainToolBarElement.attribute(QStringLiteral("name")), QStringLiteral("mainToolBar"));
+    mainToolBarElement.removeChild(mainToolBarElement.lastChildElement(QStringLiteral("Action")));
+    factory.updateClients({&client});
+    checkActions(client.toolBarByName(QStringLiteral("mainToolBar"))->actions(), QStringList() << QStringLiteral("go_up"));
+
+    // A new toolbar can't be added incrementally, the whole GUI of the client is rebuilt
+    const QByteArray newToolBarXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" >\n"
+        "<ToolBar name=\"mainToolBar\">\n"
+        "  <Action name=\"go_up\"/>\n"
+        "</ToolBar>\n"
+        "<ToolBar name=\"newToolBar\">\n"
+        "  <Action name=\"go_back\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+    client.replaceXML(newToolBarXml);
+    factory.updateClients({&client});
+
+    checkActions(client.toolBarByName(QStringLiteral("mainToolBar"))->actions(), QStringList() << QStringLiteral("go_up"));
+    checkActions(client.toolBarByName(QStringLiteral("newToolBar"))->actions(), QStringList() << QStringLiteral("go_back"));
+    QVERIFY(!factory.container(QStringLiteral("otherToolBar"), &client));
+    QVERIFY(!factory.container(QStringLiteral("file"), &client));
+
+    factory.removeClient(&client);
+}
+
+void KXmlGui_UnitTest::testSuspendClient()
+{
+    const QByteArray hostXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"host\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"file_new\"/>\n"
+        "  <Merge/>\n"
+        "  <Action name=\"file_quit\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "</gui>\n";
+    TestGuiClient hostClient(hostXml);
+    hostClient.createActions(QStringList() << QStringLiteral("file_new") << QStringLiteral("file_quit"));
+
+    const QByteArray partXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"part\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"file_print\"/>\n"
+        " </Menu>\n"
+        " <Menu name=\"view\"><text>&amp;View</text>\n"
+        "  <Action name=\"view_zoom_in\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "<ToolBar name=\"partToolBar\">\n"
+        "  <Action name=\"view_zoom_in\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+    TestGuiClient partClient(partXml);
+    partClient.createActions(QStringList() << QStringLiteral("file_print") << QStringLiteral("view_zoom_in"));
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    factory.addClient(&hostClient);
+    factory.addClient(&partClient);
+
+    QMenu *fileMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("file"), &hostClient));
+    QVERIFY(fileMenu);
+    QMenu *viewMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("view"), &partClient));
+    QVERIFY(viewMenu);
+    KToolBar *partToolBar = partClient.toolBarByName(QStringLiteral("partToolBar"));
+    QVERIFY(partToolBar);
+    QVERIFY(!partToolBar->isHidden());
+    QAction *printAction = partClient.action("file_print");
+    const QStringList fileActions{QStringLiteral("file_new"), QStringLiteral("file_print"), QStringLiteral("file_quit")};
+    checkActions(fileMenu->actions(), fileActions);
+
+    QSignalSpy makingChangesSpy(&factory, &KXMLGUIFactory::makingChanges);
+    factory.suspendClient(&partClient);
+    QVERIFY(factory.isClientSuspended(&partClient));
+    QVERIFY(!factory.isClientSuspended(&hostClient));
+    QCOMPARE(makingChangesSpy.count(), 2);
+
+    // The containers and actions stay around, they are just hidden
+    QCOMPARE(factory.container(QStringLiteral("view"), &partClient), viewMenu);
+    QCOMPARE(partClient.toolBarByName(QStringLiteral("partToolBar")), partToolBar);
+    QVERIFY(!viewMenu->menuAction()->isVisible());
+    QVERIFY(partToolBar->isHidden());
+    checkActions(fileMenu->actions(), fileActions);
+    QVERIFY(!printAction->isVisible());
+    QVERIFY(hostClient.action("file_new")->isVisible());
+
+    // Suspending twice is a no-op
+    factory.suspendClient(&partClient);
+    QCOMPARE(makingChangesSpy.count(), 2);
+
+    factory.resumeClient(&partClient);
+    QVERIFY(!factory.isClientSuspended(&partClient));
+    QVERIFY(viewMenu->menuAction()->isVisible());
+    QVERIFY(!partToolBar->isHidden());
+    QVERIFY(printAction->isVisible());
+    checkActions(fileMenu->actions(), fileActions);
+
+    // What the application does with the visibility of the actions meanwhile is kept
+    factory.suspendClient(&partClient);
+    printAction->setVisible(true);
+    printAction->setVisible(false);
+    factory.resumeClient(&partClient);
+    QVERIFY(!printAction->isVisible());
+    QVERIFY(viewMenu->menuAction()->isVisible());
+    printAction->setVisible(true);
+
+    // Also when the action gets hidden while it is hidden already
+    factory.suspendClient(&partClient);
+    printAction->setVisible(false);
+    factory.resumeClient(&partClient);
+    QVERIFY(!printAction->isVisible());
+    QVERIFY(!printAction->actionGroup());
+    printAction->setVisible(true);
+    QVERIFY(printAction->isVisible());
+
+    // A client using the same containers is shown, just the part of the suspended client stays hidden
+    const QByteArray otherPartXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"otherPart\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"view\"><text>&amp;View</text>\n"
+        "  <Action name=\"view_zoom_out\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "<ToolBar name=\"partToolBar\">\n"
+        "  <Action name=\"view_zoom_out\"/>\n"
+        "</ToolBar>\n"
+        "</gui>\n";
+    TestGuiClient otherPartClient(otherPartXml);
+    otherPartClient.createActions(QStringList() << QStringLiteral("view_zoom_out"));
+    QAction *zoomInAction = partClient.action("view_zoom_in");
+    QAction *zoomOutAction = otherPartClient.action("view_zoom_out");
+    factory.suspendClient(&partClient);
+    factory.addClient(&otherPartClient);
+    QVERIFY(viewMenu->menuAction()->isVisible());
+    QVERIFY(!partToolBar->isHidden());
+    checkActions(viewMenu->actions(), QStringList() << QStringLiteral("view_zoom_in") << QStringLiteral("view_zoom_out"));
+    checkActions(partToolBar->actions(), QStringList() << QStringLiteral("view_zoom_in") << QStringLiteral("view_zoom_out"));
+    QVERIFY(!zoomInAction->isVisible());
+    QVERIFY(zoomOutAction->isVisible());
+    QVERIFY(!printAction->isVisible());
+
+    factory.resumeClient(&partClient);
+    QVERIFY(zoomInAction->isVisible());
+    QVERIFY(zoomOutAction->isVisible());
+    QVERIFY(printAction->isVisible());
+    factory.removeClient(&otherPartClient);
+    checkActions(viewMenu->actions(), QStringList() << QStringLiteral("view_zoom_in"));
+
+    // Removing a suspended client leaves its actions visible
+    factory.suspendClient(&partClient);
+    factory.removeClient(&partClient);
+    QVERIFY(!factory.isClientSuspended(&partClient));
+    QVERIFY(printAction->isVisible());
+    checkActions(fileMenu->actions(), QStringList() << QStringLiteral("file_new") << QStringLiteral("file_quit"));
+
+    factory.removeClient(&hostClient);
+}
+
+void KXmlGui_UnitTest::testLazyMenuPopulation()
+{
+    const QByteArray hostXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"host\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"file_new\"/>\n"
+        "  <Menu name=\"file_recent\"><text>Recent</text>\n"
+        "   <Action name=\"file_open\"/>\n"
+        "  </Menu>\n"
+        "  <Merge/>\n"
+        "  <Separator/>\n"
+        "  <Action name=\"file_quit\"/>\n"
+        " </Menu>\n"
+        " <Menu name=\"go\"><text>&amp;Go</text>\n"
+        "  <Action name=\"go_up\"/>\n"
+        "  <Merge/>\n"
+        "  <ActionList name=\"go_list\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "</gui>\n";
+    const QByteArray partXml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"part\" >\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>&amp;File</text>\n"
+        "  <Action name=\"part_print\"/>\n"
+        " </Menu>\n"
+        " <Menu name=\"go\"><text>&amp;Go</text>\n"
+        "  <Action name=\"part_go\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "</gui>\n";
+
+    TestGuiClient hostClient(hostXml);
+    hostClient.createActions(QStringList() << QStringLiteral("file_new") << QStringLiteral("file_open") << QStringLiteral("file_quit")
+                                           << QStringLiteral("go_up") << QStringLiteral("go_back"));
+    TestGuiClient partClient(partXml);
+    partClient.createActions(QStringList() << QStringLiteral("part_print") << QStringLiteral("part_go"));
+
+    KMainWindow mainWindow;
+    KXMLGUIBuilder builder(&mainWindow);
+    KXMLGUIFactory factory(&builder);
+    factory.setLazyMenuPopulation(true);
+    QVERIFY(factory.lazyMenuPopulation());
+    factory.addClient(&hostClient);
+    factory.addClient(&partClient);
+
+    // The menus exist, but are empty until they are about to be shown
+    QMenu *fileMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("file"), &hostClient));
+    QVERIFY(fileMenu);
+    QVERIFY(fileMenu->actions().isEmpty());
+    Q_EMIT fileMenu->aboutToShow();
+    checkActions(fileMenu->actions(),
+                 QStringList() << QStringLiteral("file_new") << QStringLiteral("file_recent") << QStringLiteral("part_print") << QStringLiteral("separator")
+                               << QStringLiteral("file_quit"));
+
+    // Submenus are populated lazily, too
+    QMenu *recentMenu = fileMenu->actions().at(1)->menu();
+    QVERIFY(recentMenu);
+    QVERIFY(recentMenu->actions().isEmpty());
+    Q_EMIT recentMenu->aboutToShow();
+    checkActions(recentMenu->actions(), QStringList() << QStringLiteral("file_open"));
+
+    // Plugging an action list populates the menu containing it
+    QMenu *goMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("go"), &hostClient));
+    QVERIFY(goMenu);
+    QVERIFY(goMenu->actions().isEmpty());
+    hostClient.plugActionList(QStringLiteral("go_list"), QList<QAction *>() << hostClient.actionCollection()->action(QStringLiteral("go_back")));
+    checkActions(goMenu->actions(), QStringList() << QStringLiteral("go_up") << QStringLiteral("part_go") << QStringLiteral("go_back"));
+
+    factory.removeClient(&partClient);
+    factory.removeClient(&hostClient);
+    QVERIFY(!factory.container(QStringLiteral("file"), &hostClient));
+
+    // Removing a client before its menus were shown doesn't leave anything behind
+    factory.addClient(&hostClient);
+    factory.addClient(&partClient);
+    factory.removeClient(&partClient);
+    fileMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("file"), &hostClient));
+    QVERIFY(fileMenu);
+    QVERIFY(fileMenu->actions().isEmpty());
+    Q_EMIT fileMenu->aboutToShow();
+    checkActions(fileMenu->actions(),
+                 QStringList() << QStringLiteral("file_new") << QStringLiteral("file_recent") << QStringLiteral("separator") << QStringLiteral("file_quit"));
+    factory.removeClient(&hostClient);
+
+    // Suspending a client only populates the menus holding some of its GUI
+    factory.addClient(&hostClient);
+    factory.addClient(&partClient);
+    factory.suspendClient(&partClient);
+    fileMenu = qobject_cast<QMenu *>(factory.container(QStringLiteral("file"), &hostClient));
+    QVERIFY(fileMenu);
+    checkActions(fileMenu->actions(),
+                 QStringList() << QStringLiteral("file_new") << QStringLiteral("file_recent") << QStringLiteral("part_print") << QStringLiteral("separator")
+                               << QStringLiteral("file_quit"));
+    QVERIFY(!partClient.action("part_print")->isVisible());
+    recentMenu = fileMenu->actions().at(1)->menu();
+    QVERIFY(recentMenu);
+    QVERIFY(recentMenu->actions().isEmpty());
+    factory.resumeClient(&partClient);
+    QVERIFY(partClient.action("part_print")->isVisible());
+
+    factory.removeClient(&partClient);
+    factory.removeClient(&hostClient);
+}
+
 void KXmlGui_UnitTest::testTopLevelSeparator()
 {
     const QByteArray xml =
@@ -1114,6 +1826,206 @@ void KXmlGui_UnitTest::testXMLFileReplacement()
     QVERIFY(!xml.contains(QLatin1String("<ActionProperties>"))); // but no local xml file
 }
 
+// Post-processes the XML of its files, like some applications do
+class RewritingGuiClient : public TestGuiClient
+{
+public:
+    void setXML(const QString &document, bool merge = false) override
+    {
+        QString xml = document;
+        TestGuiClient::setXML(xml.replace(QLatin1String("file_open"), QLatin1String("file_close")), merge);
+    }
+};
+
+void KXmlGui_UnitTest::testDocumentCache()
+{
+    QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    const auto resetCache = qScopeGuard([] {
+        qunsetenv("KXMLGUI_DOCUMENT_CACHE");
+    });
+
+    QTemporaryFile baseFile;
+    QVERIFY(baseFile.open());
+    createXmlFile(baseFile, 2, AddToolBars);
+    baseFile.close();
+
+    QTemporaryFile xmlFile;
+    QVERIFY(xmlFile.open());
+    createXmlFile(xmlFile, 2, AddModifiedMenus | AddModifiedToolBars);
+    xmlFile.close();
+
+    enum Base {
+        NoBase,
+        UiStandards,
+        BaseFile,
+    };
+    const QStringList actions{QStringLiteral("file_open"), QStringLiteral("home")};
+    auto load = [&](bool cached, Base base, const QStringList &actions) {
+        qputenv("KXMLGUI_DOCUMENT_CACHE", cached ? QFile::encodeName(cacheDir.path()) : QByteArray("0"));
+        TestGuiClient client;
+        client.createActions(actions);
+        if (base == UiStandards) {
+            client.loadStandardsXmlFile();
+        } else if (base == BaseFile) {
+            client.setXMLFilePublic(baseFile.fileName());
+        }
+        client.setXMLFilePublic(xmlFile.fileName(), base != NoBase);
+        return client.domDocument().toString();
+    };
+
+    // Cache files are only written on cache misses, which is detected by
+    // setting their modification time far into the past
+    const QDateTime past(QDate(2000, 1, 1), QTime(0, 0), QTimeZone::UTC);
+    auto writtenCacheFiles = [&]() {
+        int count = 0;
+        const QFileInfoList infos = QDir(cacheDir.path()).entryInfoList(QDir::Files);
+        for (const QFileInfo &info : infos) {
+            if (info.lastModified(QTimeZone::UTC) != past) {
+                ++count;
+            }
+            QFile file(info.filePath());
+            if (!file.open(QIODevice::ReadWrite) || !file.setFileTime(past, QFileDevice::FileModificationTime)) {
+                qWarning() << "Could not reset" << file.fileName();
+            }
+        }
+        return count;
+    };
+    auto touch = [](const QString &fileName, const QDateTime &time) {
+        QFile file(fileName);
+        return file.open(QIODevice::ReadWrite) && file.setFileTime(time, QFileDevice::FileModificationTime);
+    };
+
+    // Cache hits give the same documents as parsing (and merging)
+    for (const Base base : {NoBase, UiStandards, BaseFile}) {
+        const QString uncached = load(false, base, actions);
+        QVERIFY(uncached.contains(QLatin1String("<Action name=\"home\"")));
+        QCOMPARE(load(true, base, actions), uncached);
+        QVERIFY(writtenCacheFiles() > 0);
+        QCOMPARE(load(true, base, actions), uncached);
+        QCOMPARE(writtenCacheFiles(), 0);
+    }
+
+    // Kiosk restrictions affect merging
+    load(true, UiStandards, actions);
+    writtenCacheFiles();
+    KConfigGroup actionRestrictions(KSharedConfig::openConfig(), QStringLiteral("KDE Action Restrictions"));
+    actionRestrictions.writeEntry("action/home", false);
+    const QString restricted = load(false, UiStandards, actions);
+    QVERIFY(!restricted.contains(QLatin1String("<Action name=\"home\"")));
+    QCOMPARE(load(true, UiStandards, actions), restricted);
+    QCOMPARE(writtenCacheFiles(), 1);
+    actionRestrictions.deleteEntry("action/home");
+    QCOMPARE(load(true, UiStandards, actions), load(false, UiStandards, actions));
+    QCOMPARE(writtenCacheFiles(), 1);
+
+    // So do the actions
+    const QStringList otherActions{QStringLiteral("home")};
+    QCOMPARE(load(true, UiStandards, otherActions), load(false, UiStandards, otherActions));
+    QCOMPARE(writtenCacheFiles(), 1);
+
+    // A different size of the file
+    QVERIFY(xmlFile.open());
+    xmlFile.resize(0);
+    createXmlFile(xmlFile, 2, AddModifiedMenus);
+    xmlFile.close();
+    QCOMPARE(load(true, NoBase, actions), load(false, NoBase, actions));
+    QCOMPARE(writtenCacheFiles(), 1);
+
+    // A different modification time of the file
+    QVERIFY(touch(xmlFile.fileName(), QDateTime::currentDateTimeUtc().addDays(-1)));
+    QCOMPARE(load(true, NoBase, actions), load(false, NoBase, actions));
+    QCOMPARE(writtenCacheFiles(), 1);
+
+    // A changed base document, the merged document has to be rebuilt as well
+    QCOMPARE(load(true, BaseFile, actions), load(false, BaseFile, actions));
+    writtenCacheFiles();
+    QCOMPARE(load(true, BaseFile, actions), load(false, BaseFile, actions));
+    QCOMPARE(writtenCacheFiles(), 0);
+    QVERIFY(touch(baseFile.fileName(), QDateTime::currentDateTimeUtc().addDays(-1)));
+    QCOMPARE(load(true, BaseFile, actions), load(false, BaseFile, actions));
+    QCOMPARE(writtenCacheFiles(), 2);
+
+    // Reimplementations of setXML() keep seeing the XML, so their results aren't cached
+    QCOMPARE(load(true, NoBase, actions), load(false, NoBase, actions));
+    writtenCacheFiles();
+    for (int i = 0; i < 2; ++i) {
+        RewritingGuiClient client;
+        client.setXMLFilePublic(xmlFile.fileName());
+        const QString xml = client.domDocument().toString();
+        QVERIFY(xml.contains(QLatin1String("<Action name=\"file_close\"")));
+        QVERIFY(!xml.contains(QLatin1String("<Action name=\"file_open\"")));
+    }
+    QCOMPARE(writtenCacheFiles(), 0);
+}
+
+void KXmlGui_UnitTest::testPrepareXMLFile()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    createXmlFile(file, 2, AddToolBars | AddActionProperties);
+    const QString fileName = file.fileName();
+    file.close();
+
+    TestGuiClient client;
+    client.setXMLFilePublic(fileName);
+
+    // Prepare the same document for several clients in parallel
+    std::vector<std::unique_ptr<TestGuiClient>> preparedClients;
+    QList<QFuture<QDomDocument>> futures;
+    for (int i = 0; i < 4; ++i) {
+        preparedClients.push_back(std::make_unique<TestGuiClient>());
+        futures.append(preparedClients.back()->prepareXMLFile(fileName));
+    }
+    for (int i = 0; i < 4; ++i) {
+        futures[i].waitForFinished();
+        preparedClients[i]->setPreparedXMLFile(fileName, futures[i].result());
+        QCOMPARE(preparedClients[i]->xmlFile(), fileName);
+        QCOMPARE(preparedClients[i]->domDocument().toString(), client.domDocument().toString());
+    }
+
+    // A missing file results in a null document
+    TestGuiClient missingClient;
+    QFuture<QDomDocument> future = missingClient.prepareXMLFile(QStringLiteral("doesnotexist_ui.rc"));
+    future.waitForFinished();
+    QVERIFY(future.result().isNull());
+}
+
+void KXmlGui_UnitTest::testTranslationDomainPropagation()
+{
+    const QByteArray xml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" translationDomain=\"foodomain\">\n"
+        "<MenuBar>\n"
+        " <Menu name=\"file\"><text>File</text>\n"
+        "  <Menu name=\"recent\"><title>Recent</title><Text translationDomain=\"other\">Recent files</Text></Menu>\n"
+        "  <Action name=\"file_open\"/>\n"
+        " </Menu>\n"
+        "</MenuBar>\n"
+        "<ToolBar name=\"mainToolBar\"><text>Main Toolbar</text></ToolBar>\n"
+        "</gui>";
+
+    TestGuiClient client(xml);
+    const QDomElement docElem = client.domDocument().documentElement();
+    QStringList domains;
+    for (const QString &tagName : {QStringLiteral("text"), QStringLiteral("title"), QStringLiteral("Text")}) {
+        const QDomNodeList elements = docElem.elementsByTagName(tagName);
+        for (int i = 0; i < elements.length(); ++i) {
+            const QDomElement e = elements.item(i).toElement();
+            domains.append(e.text() + QLatin1Char(':') + e.attribute(QStringLiteral("translationDomain")));
+        }
+    }
+    QCOMPARE(domains,
+             QStringList({QStringLiteral("File:foodomain"),
+                          QStringLiteral("Main Toolbar:foodomain"),
+                          QStringLiteral("Recent:foodomain"),
+                          QStringLiteral("Recent files:other")}));
+
+    // Other elements are left alone
+    QVERIFY(!docElem.firstChildElement(QStringLiteral("MenuBar")).hasAttribute(QStringLiteral("translationDomain")));
+}
+
 void KXmlGui_UnitTest::testClientDestruction() // #170806
 {
     const QByteArray hostXml =
@@ -1235,6 +2147,242 @@ void KXmlGui_UnitTest::testSpecificApplicationLanguageQLocale()
     QCOMPARE(QLocale::system(), originalSystemLocale);
 }
 
+void KXmlGui_UnitTest::testShortcutIndex()
+{
+    QAction ctrlX(QStringLiteral("ctrl_x"));
+    ctrlX.setShortcut(QKeySequence(Qt::CTRL | Qt::Key_X));
+    QAction ctrlXA(QStringLiteral("ctrl_x_a"));
+    ctrlXA.setShortcuts({QKeySequence(Qt::CTRL | Qt::Key_X, Qt::Key_A), QKeySequence(Qt::Key_F2)});
+    QAction none(QStringLiteral("none"));
+
+    KShortcutIndex index;
+    index.addAction(&ctrlX);
+    index.addAction(&ctrlXA);
+    index.addAction(&none);
+
+    // Whatever follows the first key combination
+    const QList<QAction *> ctrlXActions{&ctrlX, &ctrlXA};
+    QCOMPARE(index.actionsWithFirstKey(QKeySequence(Qt::CTRL | Qt::Key_X)), ctrlXActions);
+    QCOMPARE(index.actionsWithFirstKey(QKeySequence(Qt::CTRL | Qt::Key_X, Qt::Key_B)), ctrlXActions);
+    QCOMPARE(index.actionsWithFirstKey(QKeySequence(Qt::Key_F2)), QList<QAction *>{&ctrlXA});
+    QVERIFY(index.actionsWithFirstKey(QKeySequence(Qt::Key_X)).isEmpty());
+    QVERIFY(index.actionsWithFirstKey(QKeySequence()).isEmpty());
+
+    // Changed shortcuts are picked up
+    none.setShortcut(QKeySequence(Qt::Key_X));
+    QCOMPARE(index.actionsWithFirstKey(QKeySequence(Qt::Key_X)), QList<QAction *>{&none});
+    ctrlX.setShortcut(QKeySequence(Qt::Key_F2));
+    QCOMPARE(index.actionsWithFirstKey(QKeySequence(Qt::CTRL | Qt::Key_X)), QList<QAction *>{&ctrlXA});
+
+    index.removeAction(&ctrlXA);
+    QCOMPARE(index.actionsWithFirstKey(QKeySequence(Qt::Key_F2)), QList<QAction *>{&ctrlX});
+    QVERIFY(index.actionsWithFirstKey(QKeySequence(Qt::CTRL | Qt::Key_X)).isEmpty());
+}
+
+void KXmlGui_UnitTest::testAmbiguousShortcuts()
+{
+    KXmlGuiWindow mainWindow;
+    KActionCollection *ac = mainWindow.actionCollection();
+    QAction *first = ac->addAction(QStringLiteral("first"));
+    first->setShortcut(QKeySequence(Qt::Key_F21));
+    QAction *second = ac->addAction(QStringLiteral("second"));
+    second->setShortcuts({QKeySequence(Qt::Key_F23), QKeySequence(Qt::Key_F21, Qt::Key_A)});
+
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+    QCOMPARE(mainWindow.actionsForShortcut(QKeySequence(Qt::Key_F21)), QList<QAction *>{first});
+
+    // Changed shortcuts are picked up
+    second->setShortcut(QKeySequence(Qt::Key_F21));
+    QCOMPARE(mainWindow.ambiguousShortcuts(), QList<QKeySequence>{QKeySequence(Qt::Key_F21)});
+    QCOMPARE(mainWindow.actionsForShortcut(QKeySequence(Qt::Key_F21)), (QList<QAction *>{first, second}));
+
+    // Disabled and hidden actions don't count
+    second->setEnabled(false);
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+    second->setEnabled(true);
+    first->setVisible(false);
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+    first->setVisible(true);
+    QCOMPARE(mainWindow.ambiguousShortcuts().size(), 1);
+
+    // Removed actions neither
+    ac->takeAction(second);
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+    ac->addAction(QStringLiteral("second"), second);
+    QCOMPARE(mainWindow.ambiguousShortcuts().size(), 1);
+    delete second;
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+
+    // Actions limited to a widget don't conflict with the others
+    QAction *widgetAction = ac->addAction(QStringLiteral("widget_action"));
+    widgetAction->setShortcut(QKeySequence(Qt::Key_F21));
+    widgetAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+    widgetAction->setShortcutContext(Qt::WindowShortcut);
+    QCOMPARE(mainWindow.ambiguousShortcuts().size(), 1);
+    delete widgetAction;
+
+    // Actions of clients added later on count as well
+    TestGuiClient client(QByteArrayLiteral("<!DOCTYPE gui>\n<gui name=\"plugin\" version=\"1\"/>\n"));
+    client.createActions({QStringLiteral("plugin_action")});
+    QAction *pluginAction = client.actionCollection()->action(QStringLiteral("plugin_action"));
+    KActionCollection::setDefaultShortcut(pluginAction, QKeySequence(Qt::Key_F21));
+    mainWindow.guiFactory()->addClient(&client);
+    QCOMPARE(mainWindow.actionsForShortcut(QKeySequence(Qt::Key_F21)), (QList<QAction *>{first, pluginAction}));
+    mainWindow.guiFactory()->removeClient(&client);
+    QVERIFY(mainWindow.ambiguousShortcuts().isEmpty());
+}
+
+void KXmlGui_UnitTest::testAmbiguityReports()
+{
+    const QByteArray xml =
+        "<?xml version = '1.0'?>\n"
+        "<!DOCTYPE gui SYSTEM \"kpartgui.dtd\">\n"
+        "<gui version=\"1\" name=\"foo\" >\n"
+        "</gui>\n";
+    TestXmlGuiWindow mainWindow(xml, "kxmlgui_unittest.rc");
+    mainWindow.createActions({QStringLiteral("first"), QStringLiteral("second")});
+    QAction *first = mainWindow.actionCollection()->action(QStringLiteral("first"));
+    first->setShortcut(QKeySequence(Qt::Key_F21));
+    QAction *second = mainWindow.actionCollection()->action(QStringLiteral("second"));
+    second->setShortcut(QKeySequence(Qt::Key_F22));
+    mainWindow.createGUI();
+
+    // Shortcuts becoming ambiguous after createGUI() are reported as warnings, once the event loop runs
+    const QRegularExpression warning(QStringLiteral("use the same shortcut"));
+    QTest::ignoreMessage(QtWarningMsg, warning);
+    second->setShortcut(QKeySequence(Qt::Key_F21));
+    QCoreApplication::processEvents();
+
+    // Actions which are gone are forgotten, a new action with the same conflict is reported again
+    delete second;
+    QTest::ignoreMessage(QtWarningMsg, warning);
+    second = mainWindow.actionCollection()->addAction(QStringLiteral("second"));
+    second->setShortcut(QKeySequence(Qt::Key_F21));
+    QCoreApplication::processEvents();
+
+    // ...and only once
+    QTest::failOnWarning(warning);
+    second->setEnabled(false);
+    second->setEnabled(true);
+    first->setVisible(false);
+    first->setVisible(true);
+    QCoreApplication::processEvents();
+    second->setShortcut(QKeySequence(Qt::Key_F22));
+    second->setShortcut(QKeySequence(Qt::Key_F21));
+    QCoreApplication::processEvents();
+    QCOMPARE(mainWindow.ambiguousShortcuts(), QList<QKeySequence>{QKeySequence(Qt::Key_F21)});
+}
+
+void KXmlGui_UnitTest::testShortcutsEditor()
+{
+    KActionCollection collection(static_cast<QObject *>(nullptr));
+    const QStringList texts{QStringLiteral("Beta"), QStringLiteral("Action 10"), QStringLiteral("Alpha"), QStringLiteral("Action 9")};
+    for (const QString &text : texts) {
+        QAction *action = collection.addAction(text.toLower().replace(QLatin1Char(' '), QLatin1Char('_')));
+        action->setText(text);
+    }
+    QAction *beta = collection.action(QStringLiteral("beta"));
+    KActionCollection::setDefaultShortcut(beta, QKeySequence(Qt::CTRL | Qt::Key_B));
+
+    KShortcutsEditor editor(&collection, nullptr);
+    auto *view = editor.findChild<QTreeView *>();
+    QVERIFY(view);
+    const QAbstractItemModel *model = view->model();
+    QCOMPARE(model->rowCount(), 1);
+
+    // the indexes of the proxy model change with the filter
+    auto shortcutAt = [model](int row) {
+        return model->index(row, 1, model->index(0, 0)).data().value<QKeySequence>();
+    };
+    auto rowTexts = [model]() {
+        QStringList result;
+        const QModelIndex group = model->index(0, 0);
+        for (int row = 0; row < model->rowCount(group); ++row) {
+            result.append(model->index(row, 0, group).data().toString());
+        }
+        return result;
+    };
+    // Sorted naturally
+    QCOMPARE(rowTexts(), (QStringList{QStringLiteral("Action 9"), QStringLiteral("Action 10"), QStringLiteral("Alpha"), QStringLiteral("Beta")}));
+    QCOMPARE(shortcutAt(3), QKeySequence(Qt::CTRL | Qt::Key_B));
+
+    // Shortcuts changed by someone else are shown
+    beta->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_E));
+    QCOMPARE(shortcutAt(3), QKeySequence(Qt::CTRL | Qt::Key_E));
+
+    // Filtering by name and by shortcut
+    auto *searchLine = editor.findChild<QLineEdit *>();
+    QVERIFY(searchLine);
+    searchLine->setText(QStringLiteral("alp"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Alpha")});
+    searchLine->setText(QKeySequence(Qt::CTRL | Qt::Key_E).toString());
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Beta")});
+    // words of the text, object names, fuzzy matches and key sequences written differently
+    searchLine->setText(QStringLiteral("10"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Action 10")});
+    searchLine->setText(QStringLiteral("action_9"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Action 9")});
+    searchLine->setText(QStringLiteral("bta"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Beta")});
+    QAction *alpha = collection.action(QStringLiteral("alpha"));
+    alpha->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_K));
+    searchLine->setText(QStringLiteral("Shift+Ctrl+K"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Alpha")});
+    alpha->setShortcut(QKeySequence());
+    QCOMPARE(rowTexts(), QStringList());
+    searchLine->clear();
+    QCOMPARE(rowTexts().size(), 4);
+
+    // Changes can be undone
+    QVERIFY(!editor.isModified());
+    editor.allDefault();
+    QVERIFY(editor.isModified());
+    QCOMPARE(beta->shortcut(), QKeySequence(Qt::CTRL | Qt::Key_B));
+    QCOMPARE(shortcutAt(3), QKeySequence(Qt::CTRL | Qt::Key_B));
+    editor.undo();
+    QVERIFY(!editor.isModified());
+    QCOMPARE(beta->shortcut(), QKeySequence(Qt::CTRL | Qt::Key_E));
+
+    // Renamed actions are sorted again, deleted ones are dropped
+    beta->setText(QStringLiteral("Aardvark"));
+    QCOMPARE(rowTexts(), (QStringList{QStringLiteral("Aardvark"), QStringLiteral("Action 9"), QStringLiteral("Action 10"), QStringLiteral("Alpha")}));
+    delete alpha;
+    QCOMPARE(rowTexts(), (QStringList{QStringLiteral("Aardvark"), QStringLiteral("Action 9"), QStringLiteral("Action 10")}));
+
+    editor.clearCollections();
+    QCOMPARE(model->rowCount(), 0);
+}
+
+void KXmlGui_UnitTest::testShortcutsEditorFuzzySearch()
+{
+    KActionCollection collection(static_cast<QObject *>(nullptr));
+    collection.addAction(QStringLiteral("edit_cut"))->setText(QStringLiteral("Cu&t"));
+    collection.addAction(QStringLiteral("execute"))->setText(QStringLiteral("Execute"));
+
+    KShortcutsEditor editor(&collection, nullptr);
+    auto *view = editor.findChild<QTreeView *>();
+    QVERIFY(view);
+    auto *searchLine = editor.findChild<QLineEdit *>();
+    QVERIFY(searchLine);
+    const QAbstractItemModel *model = view->model();
+    auto rowTexts = [model]() {
+        QStringList result;
+        const QModelIndex group = model->index(0, 0);
+        for (int row = 0; row < model->rowCount(group); ++row) {
+            result.append(model->index(row, 0, group).data().toString());
+        }
+        return result;
+    };
+
+    // "Execute" matches "cut" fuzzily, but there is a better match
+    searchLine->setText(QStringLiteral("cut"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Cut")});
+    // Fuzzy matches are only shown when nothing else matches
+    searchLine->setText(QStringLiteral("exct"));
+    QCOMPARE(rowTexts(), QStringList{QStringLiteral("Execute")});
+}
+
 void KXmlGui_UnitTest::testSingleModifierQKeySequenceEndsWithPlus()
 {
     // Check that native texts of the Meta, Alt, Control, Shift, Keypad modifiers end in "+"
@@ -18,20 +18,31 @@ private Q_SLOTS:
     void initTestCase();
     void testFindVersionNumber_data();
     void testFindVersionNumber();
+    void testReadConfigFile();
     void testVersionHandlerSameVersion();
     void testVersionHandlerNewVersionNothingKept();
     void testVersionHandlerNewVersionUserChanges();
     void testPartMerging();
     void testPartMergingSettings();
+    void testMergingIndices();
+    void testTagKinds();
     void testShortcutSchemeMerging();
     void testUiStandardsMerging_data();
     void testUiStandardsMerging();
     void testActionListAndSeparator();
+    void testActionListOrdering();
     void testHiddenToolBar();
+    void testToolBarStateAfterRemoval();
     void testCustomPlaceToolBar();
     void testDeletedContainers();
     void testAutoSaveSettings();
     void testXMLFileReplacement();
+    void testDocumentCache();
+    void testPrepareXMLFile();
+    void testTranslationDomainPropagation();
+    void testUpdateClients();
+    void testSuspendClient();
+    void testLazyMenuPopulation();
     void testTopLevelSeparator();
     void testMenuNames();
     void testClientDestruction();
@@ -39,6 +50,11 @@ private Q_SLOTS:
     void testShortcuts();
     void testPopupMenuParent();
     void testSpecificApplicationLanguageQLocale();
+    void testShortcutIndex();
+    void testAmbiguousShortcuts();
+    void testAmbiguityReports();
+    void testShortcutsEditor();
+    void testShortcutsEditorFuzzySearch();
     void testSingleModifierQKeySequenceEndsWithPlus();
     void testSaveShortcutsAndRefresh();
 };
@@ -14,6 +14,7 @@
 #include <kxmlguifactory.h>
 
 #include <QDebug>
+#include <QDomDocument>
 
 // because setDOMDocument and setXML are protected
 class TestGuiClient : public KXMLGUIClient
@@ -26,10 +27,18 @@ public:
             setXML(QString::fromLatin1(xml));
         }
     }
+    explicit TestGuiClient(KXMLGUIClient *parent)
+        : KXMLGUIClient(parent)
+    {
+    }
     void setXMLFilePublic(const QString &file, bool merge = false, bool setXMLDoc = true)
     {
         setXMLFile(file, merge, setXMLDoc);
     }
+    void setDOMDocumentPublic(const QDomDocument &document, bool merge = false)
+    {
+        setDOMDocument(document, merge);
+    }
     void setLocalXMLFilePublic(const QString &file)
     {
         setLocalXMLFile(file);
@@ -46,6 +55,10 @@ public:
     {
         setXML(QString::fromLatin1(xml), true);
     }
+    void replaceXML(const QByteArray &xml)
+    {
+        setXML(QString::fromLatin1(xml));
+    }
     void createActions(const QStringList &actionNames)
     {
         KActionCollection *coll = actionCollection();
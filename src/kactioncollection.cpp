@@ -19,7 +19,9 @@
 
 #include "debug.h"
 #include "kactioncategory.h"
+#include "kshortcutindex_p.h"
 #include "kxmlguiclient.h"
+#include "kxmlguiconfigfile_p.h"
 #include "kxmlguifactory.h"
 
 #include <KAuthorized>
@@ -31,10 +33,13 @@
 
 #include <QDomDocument>
 #include <QGuiApplication>
+#include <QHash>
 #include <QList>
 #include <QMetaMethod>
 #include <QSet>
 
+#include <memory>
+
 static bool actionHasGlobalShortcut(const QAction *action)
 {
 #if HAVE_GLOBALACCEL
@@ -45,35 +50,47 @@ static bool actionHasGlobalShortcut(const QAction *action)
 #endif
 }
 
+// Keeps the actions in insertion order, with hashed lookups by name and by
+// action. Removal only leaves a tombstone behind, the lists are compacted
+// lazily before they are handed out, so neither adding nor removing an
+// action has to scan the whole collection.
 struct ActionStorage {
     void addAction(const QString &name, QAction *action)
     {
-        Q_ASSERT(std::find(m_actions.begin(), m_actions.end(), action) == m_actions.end());
+        Q_ASSERT(!m_actionIndexes.contains(action));
+        Q_ASSERT(!m_nameIndexes.contains(name));
+        if (m_tombstones > m_actionIndexes.size()) {
+            compact();
+        }
+        const qsizetype idx = m_actions.size();
         m_actions.push_back(action);
         m_names.push_back(name);
+        m_actionIndexes.insert(action, idx);
+        m_nameIndexes.insert(name, idx);
         Q_ASSERT(m_names.size() == m_actions.size());
     }
 
     bool removeAction(QAction *action)
     {
-        auto it = std::find(m_actions.begin(), m_actions.end(), action);
-        if (it != m_actions.end()) {
-            // We can't have the same action twice.
-            Q_ASSERT(std::find(it + 1, m_actions.end(), action) == m_actions.end());
-            auto idx = std::distance(m_actions.begin(), it);
-            m_names.erase(m_names.begin() + idx);
-            m_actions.erase(it);
-            return true;
+        auto it = m_actionIndexes.find(action);
+        if (it == m_actionIndexes.end()) {
+            return false;
         }
-        Q_ASSERT(m_names.size() == m_actions.size());
-        return false;
+        const qsizetype idx = it.value();
+        m_actionIndexes.erase(it);
+        m_nameIndexes.remove(m_names.at(idx));
+        // Leave a tombstone, see compact()
+        m_actions[idx] = nullptr;
+        m_names[idx] = QString();
+        ++m_tombstones;
+        return true;
     }
 
     QAction *findAction(const QString &name) const
     {
-        auto it = std::find(m_names.begin(), m_names.end(), name);
-        if (it != m_names.end() && *it == name) {
-            return m_actions[std::distance(m_names.begin(), it)];
+        const auto it = m_nameIndexes.constFind(name);
+        if (it != m_nameIndexes.cend()) {
+            return m_actions.at(it.value());
         }
         return nullptr;
     }
@@ -82,31 +99,68 @@ struct ActionStorage {
     {
         m_actions = {};
         m_names = {};
+        m_actionIndexes = {};
+        m_nameIndexes = {};
+        m_tombstones = 0;
     }
 
     int size() const
     {
-        return m_actions.size();
+        return m_actionIndexes.size();
     }
 
     template<typename F>
     void foreachAction(F f)
     {
+        compact();
         Q_ASSERT(m_names.size() == m_actions.size());
         for (int i = 0; i < m_actions.size(); ++i) {
-            f(m_names.at(i), m_actions.at(i));
+            // Actions removed by f() leave a tombstone behind
+            if (m_actions.at(i)) {
+                f(m_names.at(i), m_actions.at(i));
+            }
         }
     }
 
     const QList<QAction *> &actions() const
     {
+        compact();
         return m_actions;
     }
 
 private:
-    // 1:1 list of names and actions
-    QList<QString> m_names;
-    QList<QAction *> m_actions;
+    // Drops the tombstones left by removeAction() and reindexes what's left
+    void compact() const
+    {
+        if (m_tombstones == 0) {
+            return;
+        }
+        qsizetype dst = 0;
+        for (qsizetype src = 0; src < m_actions.size(); ++src) {
+            QAction *action = m_actions.at(src);
+            if (!action) {
+                continue;
+            }
+            if (dst != src) {
+                m_actions[dst] = action;
+                m_names[dst] = m_names.at(src);
+                m_actionIndexes[action] = dst;
+                m_nameIndexes[m_names.at(dst)] = dst;
+            }
+            ++dst;
+        }
+        m_actions.resize(dst);
+        m_names.resize(dst);
+        m_tombstones = 0;
+    }
+
+    // 1:1 list of names and actions, a nullptr action marks a removed entry
+    mutable QList<QString> m_names;
+    mutable QList<QAction *> m_actions;
+    // name/action -> position in the lists above
+    mutable QHash<QString, qsizetype> m_nameIndexes;
+    mutable QHash<QAction *, qsizetype> m_actionIndexes;
+    mutable qsizetype m_tombstones = 0;
 };
 
 class KActionCollectionPrivate
@@ -158,6 +212,12 @@ public:
     bool connectHovered : 1;
 
     QList<QWidget *> associatedWidgets;
+
+    // see KActionCollection::shortcutIndex()
+    std::unique_ptr<KShortcutIndex> shortcutIndex;
+
+    // see KActionCollection::writtenSettingsCount()
+    int writtenSettingsCount = 0;
 };
 
 QList<KActionCollection *> KActionCollectionPrivate::s_allCollections;
@@ -384,6 +444,10 @@ QAction *KActionCollection::addAction(const QString &name, QAction *action)
         connect(action, &QAction::triggered, this, &KActionCollection::slotActionTriggered);
     }
 
+    if (d->shortcutIndex) {
+        d->shortcutIndex->addAction(action);
+    }
+
     Q_EMIT inserted(action);
     Q_EMIT changed();
     return action;
@@ -642,9 +706,8 @@ bool KActionCollectionPrivate::writeKXMLGUIConfigFile()
     QString attrShortcut = QStringLiteral("shortcut");
 
     // Read XML file
-    QString sXml(KXMLGUIFactory::readConfigFile(kxmlguiClient->xmlFile(), q->componentName()));
     QDomDocument doc;
-    doc.setContent(sXml);
+    doc.setContent(KXmlGuiConfigFile(kxmlguiClient->xmlFile(), q->componentName()).data());
 
     // Process XML data
 
@@ -699,6 +762,8 @@ bool KActionCollectionPrivate::writeKXMLGUIConfigFile()
 
 void KActionCollection::writeSettings(KConfigGroup *config, bool writeAll, QAction *oneAction) const
 {
+    d->writtenSettingsCount = 0;
+
     // If the caller didn't provide a config group we try to save the KXMLGUI
     // Configuration file. If that succeeds we are finished.
     if (config == nullptr && d->writeKXMLGUIConfigFile()) {
@@ -710,15 +775,8 @@ void KActionCollection::writeSettings(KConfigGroup *config, bool writeAll, QActi
         config = &cg;
     }
 
-    QList<QAction *> writeActions;
-    if (oneAction) {
-        writeActions.append(oneAction);
-    } else {
-        writeActions = actions();
-    }
-
-    d->actionStore.foreachAction([config, this, writeAll](const QString &actionName, QAction *action) {
-        if (!action) {
+    d->actionStore.foreachAction([config, this, writeAll, oneAction](const QString &actionName, QAction *action) {
+        if (!action || (oneAction && action != oneAction)) {
             return;
         }
 
@@ -729,9 +787,9 @@ void KActionCollection::writeSettings(KConfigGroup *config, bool writeAll, QActi
             return;
         }
 
-        // Write the shortcut
+        // Write the shortcut, unless the config has it already
         if (isShortcutsConfigurable(action)) {
-            bool bConfigHasAction = !config->readEntry(actionName, QString()).isEmpty();
+            const QString configEntry = config->readEntry(actionName, QString());
             bool bSameAsDefault = (action->shortcuts() == defaultShortcuts(action));
             // If we're using a global config or this setting
             //  differs from the default, then we want to write.
@@ -749,19 +807,31 @@ void KActionCollection::writeSettings(KConfigGroup *config, bool writeAll, QActi
                 if (s.isEmpty()) {
                     s = QStringLiteral("none");
                 }
-                qCDebug(DEBUG_KXMLGUI) << "\twriting " << actionName << " = " << s;
-                config->writeEntry(actionName, s, flags);
+                if (s != configEntry) {
+                    qCDebug(DEBUG_KXMLGUI) << "\twriting " << actionName << " = " << s;
+                    config->writeEntry(actionName, s, flags);
+                    ++d->writtenSettingsCount;
+                }
 
-            } else if (bConfigHasAction) {
+            } else if (!configEntry.isEmpty()) {
                 // Otherwise, this key is the same as default but exists in
                 // config file. Remove it.
                 qCDebug(DEBUG_KXMLGUI) << "\tremoving " << actionName << " because == default";
                 config->deleteEntry(actionName, flags);
+                ++d->writtenSettingsCount;
             }
         }
     });
 
-    config->sync();
+    // Syncing can be expensive, e.g. with the config on a network file system
+    if (d->writtenSettingsCount > 0) {
+        config->sync();
+    }
+}
+
+int KActionCollection::writtenSettingsCount() const
+{
+    return d->writtenSettingsCount;
 }
 
 void KActionCollection::slotActionTriggered()
@@ -874,6 +944,10 @@ QAction *KActionCollectionPrivate::unlistAction(QAction *action)
         return nullptr;
     }
 
+    if (shortcutIndex) {
+        shortcutIndex->removeAction(action);
+    }
+
     // Remove the action from the categories. Should be only one
     const QList<KActionCategory *> categories = q->findChildren<KActionCategory *>();
     for (KActionCategory *category : categories) {
@@ -883,6 +957,17 @@ QAction *KActionCollectionPrivate::unlistAction(QAction *action)
     return action;
 }
 
+KShortcutIndex *KActionCollection::shortcutIndex() const
+{
+    if (!d->shortcutIndex) {
+        d->shortcutIndex = std::make_unique<KShortcutIndex>();
+        for (QAction *action : d->actionStore.actions()) {
+            d->shortcutIndex->addAction(action);
+        }
+    }
+    return d->shortcutIndex.get();
+}
+
 QList<QWidget *> KActionCollection::associatedWidgets() const
 {
     return d->associatedWidgets;
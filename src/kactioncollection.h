@@ -24,6 +24,7 @@
 
 class KXMLGUIClient;
 class KConfigGroup;
+class KShortcutIndex;
 class QActionGroup;
 class QString;
 
@@ -189,9 +190,26 @@ public:
      *
      * \a oneAction pass an action here if you just want to save the values for one action, eg.
      *                  if you know that action is the only one which has changed.
+     *
+     * Only the entries which differ from the shortcuts of the actions are written or
+     * removed. The config is only synced when that happened, so callers which rely on
+     * this call to also flush their own pending changes to the same config have to
+     * call KConfig::sync() themselves.
+     *
+     * \sa writtenSettingsCount()
      */
     void writeSettings(KConfigGroup *config = nullptr, bool writeDefaults = false, QAction *oneAction = nullptr) const;
 
+    /*!
+     * \brief Returns the number of entries written to or removed from the config group
+     * by the last call of writeSettings().
+     *
+     * This is mostly useful for tests.
+     *
+     * \since 6.30
+     */
+    int writtenSettingsCount() const;
+
     /*!
      * \brief The number of actions in the collection.
      *
@@ -732,6 +750,10 @@ public:
 private:
     KXMLGUI_NO_EXPORT explicit KActionCollection(const KXMLGUIClient *parent); // used by KXMLGUIClient
 
+    friend class KKeySequenceWidgetPrivate;
+    // The shortcuts of the actions by their first key combination, created on first use
+    KXMLGUI_NO_EXPORT KShortcutIndex *shortcutIndex() const;
+
     friend class KActionCollectionPrivate;
     class KActionCollectionPrivate *const d;
 };
@@ -962,16 +962,10 @@ void KEditToolBarWidget::rebuildKXMLGUIClients()
         return;
     }
 
-    // remove the elements starting from the last going to the first
-    for (auto it = clients.crbegin(); it != clients.crend(); ++it) {
-        // qDebug() << "factory->removeClient " << client;
-        d->m_factory->removeClient(*it);
-    }
-
     KXMLGUIClient *firstClient = clients.first();
 
-    // now, rebuild the gui from the first to the last
-    // qDebug(240) << "rebuilding the gui";
+    // reload the XML of all clients first, so that the factory can update the
+    // containers that actually changed instead of rebuilding the whole GUI
     for (KXMLGUIClient *client : clients) {
         // qDebug(240) << "updating client " << client << " " << client->componentName() << "  xmlFile=" << client->xmlFile();
         QString file(client->xmlFile()); // before setting ui_standards!
@@ -991,12 +985,10 @@ void KEditToolBarWidget::rebuildKXMLGUIClients()
         }
     }
 
-    // Now we can add the clients to the factory
-    // We don't do it in the loop above because adding a part automatically
+    // Now we can update the GUI of the clients
+    // We don't do it in the loop above because (re-)adding a part automatically
     // adds its plugins, so we must make sure the plugins were updated first.
-    for (KXMLGUIClient *client : clients) {
-        d->m_factory->addClient(client);
-    }
+    d->m_factory->updateClients(clients);
 }
 
 void KEditToolBarWidgetPrivate::setupLayout()
@@ -14,6 +14,7 @@
 
 #include "debug.h"
 #include "kactioncollection.h"
+#include "kshortcutindex_p.h"
 
 #include <QAction>
 #include <QApplication>
@@ -206,15 +207,12 @@ bool KKeySequenceWidgetPrivate::conflictWithLocalShortcuts(const QKeySequence &k
         return false;
     }
 
-    // Add all the actions from the checkActionCollections list to a single list to
-    // be able to process them in a single loop below.
-    // Note that this can't be done in setCheckActionCollections(), because we
-    // keep pointers to the action collections, and between the call to
-    // setCheckActionCollections() and this function some actions might already be
-    // removed from the collection again.
-    QList<QAction *> allActions;
+    // Only the actions with a shortcut starting with the same key combination can
+    // conflict, see below. These are looked up in the shortcut indices of the
+    // collections, which are kept up to date when the collections change.
+    QList<QAction *> candidateActions;
     for (KActionCollection *collection : std::as_const(checkActionCollections)) {
-        allActions += collection->actions();
+        candidateActions += collection->shortcutIndex()->actionsWithFirstKey(keySequence);
     }
 
     // Because of multikey shortcuts we can have clashes with many shortcuts.
@@ -237,7 +235,7 @@ bool KKeySequenceWidgetPrivate::conflictWithLocalShortcuts(const QKeySequence &k
     QList<QAction *> conflictingActions;
 
     // find conflicting shortcuts with existing actions
-    for (QAction *qaction : std::as_const(allActions)) {
+    for (QAction *qaction : std::as_const(candidateActions)) {
         if (shortcutsConflictWith(qaction->shortcuts(), keySequence)) {
             // A conflict with a KAction. If that action is configurable
             // ask the user what to do. If not reject this keySequence.
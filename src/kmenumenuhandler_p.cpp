@@ -14,6 +14,7 @@
 #include "ktoolbar.h"
 #include "kxmlguibuilder.h"
 #include "kxmlguiclient.h"
+#include "kxmlguiconfigfile_p.h"
 #include "kxmlguifactory.h"
 
 #include <QAction>
@@ -175,7 +176,7 @@ void KMenuMenuHandler::slotAddToToolBar(int tb)
     const KXMLGUIClient *client = collection->parentGUIClient();
     QString xmlFile = client->localXMLFile();
     QDomDocument document;
-    document.setContent(KXMLGUIFactory::readConfigFile(client->xmlFile(), client->componentName()));
+    document.setContent(KXmlGuiConfigFile(client->xmlFile(), client->componentName()).data());
     QDomElement elem = document.documentElement().toElement();
 
     const QLatin1String tagToolBar("ToolBar");
@@ -0,0 +1,108 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kshortcutindex_p.h"
+
+#include <QAction>
+
+KShortcutIndex::KShortcutIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void KShortcutIndex::addAction(QAction *action)
+{
+    if (m_firstKeys.contains(action)) {
+        return;
+    }
+
+    const QList<int> keys = firstKeys(action);
+    m_firstKeys.insert(action, keys);
+    insertKeys(action, keys);
+
+    // QAction has no signal for shortcut changes only
+    connect(action, &QAction::changed, this, [this, action]() {
+        updateAction(action);
+    });
+}
+
+void KShortcutIndex::removeAction(QAction *action)
+{
+    const auto it = m_firstKeys.find(action);
+    if (it == m_firstKeys.end()) {
+        return;
+    }
+
+    removeKeys(action, it.value());
+    m_firstKeys.erase(it);
+
+    // the connection is gone anyway if the action is being destroyed
+    disconnect(action, nullptr, this, nullptr);
+}
+
+QList<QAction *> KShortcutIndex::actionsWithFirstKey(const QKeySequence &sequence) const
+{
+    if (sequence.isEmpty()) {
+        return {};
+    }
+    return m_actionsByFirstKey.value(sequence[0].toCombined());
+}
+
+void KShortcutIndex::updateAction(QAction *action)
+{
+    const auto it = m_firstKeys.find(action);
+    if (it == m_firstKeys.end()) {
+        return;
+    }
+
+    const QList<int> keys = firstKeys(action);
+    if (keys == it.value()) {
+        return;
+    }
+
+    removeKeys(action, it.value());
+    insertKeys(action, keys);
+    it.value() = keys;
+}
+
+void KShortcutIndex::insertKeys(QAction *action, const QList<int> &keys)
+{
+    for (int key : keys) {
+        m_actionsByFirstKey[key].append(action);
+    }
+}
+
+void KShortcutIndex::removeKeys(QAction *action, const QList<int> &keys)
+{
+    for (int key : keys) {
+        const auto it = m_actionsByFirstKey.find(key);
+        if (it == m_actionsByFirstKey.end()) {
+            continue;
+        }
+        it->removeOne(action);
+        if (it->isEmpty()) {
+            m_actionsByFirstKey.erase(it);
+        }
+    }
+}
+
+QList<int> KShortcutIndex::firstKeys(const QAction *action)
+{
+    QList<int> keys;
+    const QList<QKeySequence> shortcuts = action->shortcuts();
+    for (const QKeySequence &shortcut : shortcuts) {
+        if (shortcut.isEmpty()) {
+            continue;
+        }
+        const int key = shortcut[0].toCombined();
+        // e.g. Ctrl+X,A and Ctrl+X,B
+        if (!keys.contains(key)) {
+            keys.append(key);
+        }
+    }
+    return keys;
+}
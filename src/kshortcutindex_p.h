@@ -0,0 +1,54 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KSHORTCUTINDEX_P_H
+#define KSHORTCUTINDEX_P_H
+
+#include <QHash>
+#include <QKeySequence>
+#include <QList>
+#include <QObject>
+
+class QAction;
+
+/*!
+ * \internal
+ * \inmodule KXmlGui
+ * \brief The actions of a KActionCollection by the first key combination of their shortcuts.
+ *
+ * Two shortcuts only clash when one of them is a prefix of the other (or when they are
+ * the same), so only actions sharing the first key combination of a key sequence have to
+ * be checked for conflicts with it, instead of all actions.
+ *
+ * Created on demand by KActionCollection::shortcutIndex() and kept up to date when actions
+ * are added to or removed from the collection, and when their shortcuts change.
+ */
+class KShortcutIndex : public QObject
+{
+public:
+    explicit KShortcutIndex(QObject *parent = nullptr);
+
+    void addAction(QAction *action);
+    // Only uses the pointer, the action might be being destroyed
+    void removeAction(QAction *action);
+
+    // The actions with a shortcut starting with the first key combination of sequence
+    QList<QAction *> actionsWithFirstKey(const QKeySequence &sequence) const;
+
+private:
+    void updateAction(QAction *action);
+    void insertKeys(QAction *action, const QList<int> &keys);
+    void removeKeys(QAction *action, const QList<int> &keys);
+    static QList<int> firstKeys(const QAction *action);
+
+    // first key combination (QKeyCombination::toCombined()) -> actions
+    QHash<int, QList<QAction *>> m_actionsByFirstKey;
+    // action -> the keys it is listed under above
+    QHash<QAction *, QList<int>> m_firstKeys;
+};
+
+#endif
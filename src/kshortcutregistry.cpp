@@ -0,0 +1,267 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kshortcutregistry_p.h"
+
+#include "kactioncollection.h"
+
+#include <QAction>
+
+KShortcutRegistry::KShortcutRegistry(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void KShortcutRegistry::addCollection(KActionCollection *collection)
+{
+    if (m_collections.contains(collection)) {
+        return;
+    }
+
+    QSet<QAction *> &actions = m_collections[collection];
+    const QList<QAction *> collectionActions = collection->actions();
+    for (QAction *action : collectionActions) {
+        actions.insert(action);
+        addAction(action);
+    }
+
+    connect(collection, &KActionCollection::inserted, this, [this, collection](QAction *action) {
+        const auto it = m_collections.find(collection);
+        if (it != m_collections.end() && !it->contains(action)) {
+            it->insert(action);
+            addAction(action);
+        }
+    });
+    // There is no signal for removed actions, but they change the number of actions
+    connect(collection, &KActionCollection::changed, this, [this, collection]() {
+        const auto it = m_collections.constFind(collection);
+        if (it != m_collections.cend() && it->size() != collection->count()) {
+            syncCollection(collection);
+        }
+    });
+    connect(collection, &QObject::destroyed, this, [this, collection]() {
+        removeCollection(collection);
+    });
+}
+
+void KShortcutRegistry::removeCollection(KActionCollection *collection)
+{
+    const auto it = m_collections.find(collection);
+    if (it == m_collections.end()) {
+        return;
+    }
+
+    const QSet<QAction *> actions = *it;
+    m_collections.erase(it);
+    for (QAction *action : actions) {
+        removeAction(action);
+    }
+
+    // only uses the pointer, so this is fine while the collection is being destroyed
+    disconnect(collection, nullptr, this, nullptr);
+}
+
+QList<KActionCollection *> KShortcutRegistry::collections() const
+{
+    return m_collections.keys();
+}
+
+QList<QAction *> KShortcutRegistry::actions(const QKeySequence &shortcut) const
+{
+    return m_actionsByShortcut.value(shortcut);
+}
+
+QList<QKeySequence> KShortcutRegistry::ambiguousShortcuts() const
+{
+    QList<QKeySequence> shortcuts;
+    for (auto it = m_actionsByShortcut.cbegin(); it != m_actionsByShortcut.cend(); ++it) {
+        if (it->size() > 1) {
+            shortcuts.append(it.key());
+        }
+    }
+    return shortcuts;
+}
+
+void KShortcutRegistry::setAmbiguityHandler(const AmbiguityHandler &handler)
+{
+    m_handler = handler;
+    if (!m_newAmbiguities.isEmpty()) {
+        scheduleReport();
+    }
+}
+
+QList<QKeySequence> KShortcutRegistry::takeNewAmbiguities()
+{
+    QList<QKeySequence> shortcuts;
+    for (const QKeySequence &shortcut : std::as_const(m_newAmbiguities)) {
+        if (m_actionsByShortcut.value(shortcut).size() > 1) {
+            shortcuts.append(shortcut);
+        }
+    }
+    m_newAmbiguities.clear();
+    return shortcuts;
+}
+
+void KShortcutRegistry::setRemovalHandler(const RemovalHandler &handler)
+{
+    m_removalHandler = handler;
+}
+
+void KShortcutRegistry::addAction(QAction *action)
+{
+    Entry &entry = m_entries[action];
+    if (entry.collectionCount++ > 0) {
+        return;
+    }
+
+    entry.assignedShortcuts = action->shortcuts();
+    entry.shortcuts = activeShortcuts(action);
+    insertShortcuts(action, entry.shortcuts);
+
+    // QAction has no signal for shortcut changes only, this also covers enabled and visible
+    connect(action, &QAction::changed, this, [this, action]() {
+        updateAction(action);
+    });
+    connect(action, &QObject::destroyed, this, [this, action]() {
+        removeAction(action, true);
+    });
+}
+
+void KShortcutRegistry::removeAction(QAction *action, bool force)
+{
+    const auto it = m_entries.find(action);
+    if (it == m_entries.end()) {
+        return;
+    }
+    if (!force && --it->collectionCount > 0) {
+        return;
+    }
+
+    removeShortcuts(action, it->shortcuts);
+    m_entries.erase(it);
+
+    if (force) {
+        for (QSet<QAction *> &actions : m_collections) {
+            actions.remove(action);
+        }
+    }
+
+    disconnect(action, nullptr, this, nullptr);
+
+    if (m_removalHandler) {
+        m_removalHandler(action);
+    }
+}
+
+void KShortcutRegistry::updateAction(QAction *action)
+{
+    const auto it = m_entries.find(action);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    const QList<QKeySequence> assignedShortcuts = action->shortcuts();
+    const bool shortcutsChanged = assignedShortcuts != it->assignedShortcuts;
+    it->assignedShortcuts = assignedShortcuts;
+
+    const QList<QKeySequence> shortcuts = activeShortcuts(action);
+    if (shortcuts == it->shortcuts) {
+        return;
+    }
+
+    removeShortcuts(action, it->shortcuts);
+    it->shortcuts = shortcuts;
+    // the conflicts of an action which was just enabled or shown again aren't new
+    insertShortcuts(action, shortcuts, shortcutsChanged);
+}
+
+void KShortcutRegistry::syncCollection(KActionCollection *collection)
+{
+    QSet<QAction *> &actions = m_collections[collection];
+    const QList<QAction *> collectionActions = collection->actions();
+    const QSet<QAction *> current(collectionActions.cbegin(), collectionActions.cend());
+
+    for (auto it = actions.begin(); it != actions.end();) {
+        if (current.contains(*it)) {
+            ++it;
+        } else {
+            QAction *action = *it;
+            it = actions.erase(it);
+            removeAction(action);
+        }
+    }
+    for (QAction *action : collectionActions) {
+        if (!actions.contains(action)) {
+            actions.insert(action);
+            addAction(action);
+        }
+    }
+}
+
+void KShortcutRegistry::insertShortcuts(QAction *action, const QList<QKeySequence> &shortcuts, bool report)
+{
+    for (const QKeySequence &shortcut : shortcuts) {
+        QList<QAction *> &actions = m_actionsByShortcut[shortcut];
+        actions.append(action);
+        if (report && actions.size() > 1) {
+            m_newAmbiguities.insert(shortcut);
+            scheduleReport();
+        }
+    }
+}
+
+void KShortcutRegistry::removeShortcuts(QAction *action, const QList<QKeySequence> &shortcuts)
+{
+    for (const QKeySequence &shortcut : shortcuts) {
+        const auto it = m_actionsByShortcut.find(shortcut);
+        if (it == m_actionsByShortcut.end()) {
+            continue;
+        }
+        it->removeOne(action);
+        if (it->isEmpty()) {
+            m_actionsByShortcut.erase(it);
+        }
+    }
+}
+
+void KShortcutRegistry::scheduleReport()
+{
+    if (!m_handler || m_reportScheduled) {
+        return;
+    }
+
+    m_reportScheduled = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            m_reportScheduled = false;
+            const QList<QKeySequence> shortcuts = takeNewAmbiguities();
+            if (!shortcuts.isEmpty() && m_handler) {
+                m_handler(shortcuts);
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+QList<QKeySequence> KShortcutRegistry::activeShortcuts(const QAction *action)
+{
+    QList<QKeySequence> shortcuts;
+    if (!action->isEnabled() || !action->isVisible()) {
+        return shortcuts;
+    }
+    if (action->shortcutContext() == Qt::WidgetShortcut || action->shortcutContext() == Qt::WidgetWithChildrenShortcut) {
+        return shortcuts;
+    }
+
+    const QList<QKeySequence> actionShortcuts = action->shortcuts();
+    for (const QKeySequence &shortcut : actionShortcuts) {
+        if (!shortcut.isEmpty() && !shortcuts.contains(shortcut)) {
+            shortcuts.append(shortcut);
+        }
+    }
+    return shortcuts;
+}
@@ -0,0 +1,96 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KSHORTCUTREGISTRY_P_H
+#define KSHORTCUTREGISTRY_P_H
+
+#include <QHash>
+#include <QKeySequence>
+#include <QList>
+#include <QObject>
+#include <QSet>
+
+#include <functional>
+
+class QAction;
+class KActionCollection;
+
+/*!
+ * \internal
+ * \inmodule KXmlGui
+ * \brief The shortcuts of the actions in a set of KActionCollections, used by
+ * KXmlGuiWindow to find ambiguous shortcuts.
+ *
+ * Only enabled and visible actions are taken into account, as Qt doesn't trigger
+ * the others anyway, and only if their shortcut context is the window or the whole
+ * application. The shortcuts of an action limited to a widget only conflict with
+ * the ones of the actions of the same widget, which the registry can't tell. The registry is updated as actions are added to or removed
+ * from the collections, and when their shortcuts or their state change, so that
+ * no full scan is needed when the GUI is rebuilt.
+ *
+ * Shortcuts becoming ambiguous are collected and passed to the handler in one go
+ * once control returns to the event loop, so that conflicts which only exist
+ * temporarily (e.g. while the user-defined shortcuts are being applied) are not reported.
+ * Only added actions and changed shortcuts can make a shortcut newly ambiguous, an
+ * action being enabled or shown again can't.
+ */
+class KShortcutRegistry : public QObject
+{
+public:
+    using AmbiguityHandler = std::function<void(const QList<QKeySequence> &)>;
+    using RemovalHandler = std::function<void(QAction *)>;
+
+    explicit KShortcutRegistry(QObject *parent = nullptr);
+
+    void addCollection(KActionCollection *collection);
+    void removeCollection(KActionCollection *collection);
+    QList<KActionCollection *> collections() const;
+
+    // The enabled and visible actions using shortcut
+    QList<QAction *> actions(const QKeySequence &shortcut) const;
+    // The shortcuts used by more than one enabled and visible action
+    QList<QKeySequence> ambiguousShortcuts() const;
+
+    void setAmbiguityHandler(const AmbiguityHandler &handler);
+    // The shortcuts which became ambiguous since the last call (and are still ambiguous),
+    // they are not passed to the handler anymore
+    QList<QKeySequence> takeNewAmbiguities();
+    // Called with the actions which are not in any of the collections anymore (or are
+    // being destroyed)
+    void setRemovalHandler(const RemovalHandler &handler);
+
+private:
+    struct Entry {
+        // what the action is listed under in m_actionsByShortcut
+        QList<QKeySequence> shortcuts;
+        // the shortcuts of the action, whether it is enabled and visible or not
+        QList<QKeySequence> assignedShortcuts;
+        // in how many of our collections the action is
+        int collectionCount = 0;
+    };
+
+    void addAction(QAction *action);
+    // Only uses the pointer, the action might be being destroyed
+    void removeAction(QAction *action, bool force = false);
+    void updateAction(QAction *action);
+    void syncCollection(KActionCollection *collection);
+    void insertShortcuts(QAction *action, const QList<QKeySequence> &shortcuts, bool report = true);
+    void removeShortcuts(QAction *action, const QList<QKeySequence> &shortcuts);
+    void scheduleReport();
+    static QList<QKeySequence> activeShortcuts(const QAction *action);
+
+    QHash<KActionCollection *, QSet<QAction *>> m_collections;
+    QHash<QAction *, Entry> m_entries;
+    // QKeySequence is hashed through its key combinations, no string conversion involved
+    QHash<QKeySequence, QList<QAction *>> m_actionsByShortcut;
+    QSet<QKeySequence> m_newAmbiguities;
+    AmbiguityHandler m_handler;
+    RemovalHandler m_removalHandler;
+    bool m_reportScheduled = false;
+};
+
+#endif
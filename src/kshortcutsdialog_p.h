@@ -15,24 +15,32 @@
 
 #include <KExtendableItemDelegate>
 
+#include <QAbstractItemModel>
 #include <QCollator>
 #include <QGroupBox>
+#include <QHash>
 #include <QKeySequence>
 #include <QList>
 #include <QMetaType>
 #include <QModelIndex>
-#include <QTreeWidget>
+#include <QSet>
+#include <QSortFilterProxyModel>
+#include <QTreeView>
 
+#include <map>
+#include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 class QLabel;
-class QTreeWidgetItem;
 class QRadioButton;
 class QAction;
 class KActionCollection;
 class QPushButton;
 class QComboBox;
 class KShortcutsDialog;
+class KShortcutsEditorModel;
 
 enum ColumnDesignation {
     Name = 0,
@@ -51,11 +59,6 @@ enum MyRoles {
     ObjectRole,
 };
 
-enum ItemTypes {
-    NonActionItem = 0,
-    ActionItem = 1,
-};
-
 QKeySequence primarySequence(const QList<QKeySequence> &sequences);
 QKeySequence alternateSequence(const QList<QKeySequence> &sequences);
 
@@ -77,7 +80,7 @@ class KShortcutsEditorDelegate : public KExtendableItemDelegate
 {
     Q_OBJECT
 public:
-    KShortcutsEditorDelegate(QTreeWidget *parent, KKeySequenceRecorder::Patterns patterns);
+    KShortcutsEditorDelegate(QTreeView *parent, KShortcutsEditorModel *model, KKeySequenceRecorder::Patterns patterns);
 
     // reimplemented to have some extra height
     QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
@@ -93,13 +96,15 @@ public:
 Q_SIGNALS:
     void shortcutChanged(const QKeySequence &, const QModelIndex &);
 public Q_SLOTS:
-    void hiddenBySearchLine(QTreeWidgetItem *, bool);
+    //! Closes the editor when its row is filtered out by the search line
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
 
 protected:
     bool eventFilter(QObject *, QEvent *) override;
 
 private:
     mutable QPersistentModelIndex m_editingIndex;
+    KShortcutsEditorModel *const m_model;
     const KKeySequenceRecorder::Patterns m_patterns;
     QWidget *m_editor = nullptr;
 
@@ -233,24 +238,27 @@ private:
 class QAction;
 
 /*!
- * A QTreeWidgetItem that can handle QActions.
+ * The data of an action row of KShortcutsEditorModel.
  *
  * It provides undo, commit functionality for changes made. Changes are effective immediately. You
  * have to commit them or they will be undone when deleting the item.
  *
+ * The shortcuts shown are cached, they are only looked up (again) when the row is shown
+ * (again) after a change.
+ *
  * \internal
  */
-class KShortcutsEditorItem : public QTreeWidgetItem
+class KShortcutsEditorItem
 {
 public:
-    KShortcutsEditorItem(QTreeWidgetItem *parent, QAction *action);
+    explicit KShortcutsEditorItem(QAction *action);
 
     /*!
      * Destructor
      *
      * Will undo pending changes. If you don't want that. Call commitChanges before
      */
-    ~KShortcutsEditorItem() override;
+    ~KShortcutsEditorItem();
 
     //! Undo the changes since the last commit.
     void undo();
@@ -258,8 +266,10 @@ public:
     //! Commit the changes.
     void commit();
 
-    QVariant data(int column, int role = Qt::DisplayRole) const override;
-    bool operator<(const QTreeWidgetItem &other) const override;
+    QVariant data(int column, int role = Qt::DisplayRole) const;
+
+    //! What is shown in the Name column for \a action
+    static QString actionNameInTable(const QAction *action);
 
     QKeySequence keySequence(uint column) const;
     void setKeySequence(uint column, const QKeySequence &seq);
@@ -272,9 +282,32 @@ public:
         m_isNameBold = flag;
     }
 
+    QAction *action() const
+    {
+        return m_action;
+    }
+
+    //! Drop the cached shortcuts, e.g. after they were changed by someone else
+    void invalidate()
+    {
+        m_cache.reset();
+    }
+
 private:
     friend class KShortcutsEditorPrivate;
 
+    //! What is shown for the shortcut columns, looked up on demand
+    struct Cache {
+        QList<QKeySequence> shortcuts;
+        QList<QKeySequence> defaultShortcuts;
+        bool isConfigurable = true;
+        // only used with KGlobalAccel
+        bool hasGlobalShortcut = false;
+        QList<QKeySequence> globalShortcuts;
+        QList<QKeySequence> defaultGlobalShortcuts;
+    };
+    const Cache &cache() const;
+
     //! Recheck modified status - could have changed back to initial value
     void updateModified();
 
@@ -294,8 +327,170 @@ private:
     //! The action id. Needed for exporting and importing
     QString m_id;
 
-    //! The collator, for sorting
+    mutable std::optional<Cache> m_cache;
+};
+
+/*!
+ * The index used by the search line of KShortcutsEditor.
+ *
+ * An action is found by
+ * \list
+ * \li a prefix of its (localized) text, with or without accelerator marker, or of any word of it
+ * \li a prefix of its object name, or of any word of it
+ * \li a prefix of one of its shortcuts as shown (native text) or as stored (portable text)
+ * \li one of its shortcuts, when the search text is a key sequence, e.g. "Shift+Ctrl+K"
+ * \li a fuzzy match of its text, for search texts of at least three characters, only
+ *     when no action is found otherwise
+ * \endlist
+ *
+ * The terms are kept in one sorted list, so that prefix searches are a binary search.
+ *
+ * \internal
+ */
+class KShortcutsEditorSearchIndex
+{
+public:
+    void addAction(QAction *action);
+    //! Updates the terms of \a action, e.g. after its shortcuts changed
+    void updateAction(QAction *action);
+    //! Only uses the pointer, the action might be being destroyed
+    void removeAction(QAction *action);
+    void clear();
+
+    //! The actions matching \a text
+    QSet<QAction *> search(const QString &text) const;
+
+    //! Changes with every change of the index
+    quint64 revision() const
+    {
+        return m_revision;
+    }
+
+private:
+    struct Entry {
+        //! Lower case, for fuzzy matching
+        QString name;
+        //! Lower case
+        QStringList terms;
+        QList<QKeySequence> shortcuts;
+    };
+    static Entry entryForAction(QAction *action);
+    void insertEntry(QAction *action, const Entry &entry);
+    void removeEntry(QAction *action, const Entry &entry);
+
+    QHash<QAction *, Entry> m_entries;
+    //! The actions by term, sorted so that the terms starting with a text are in one range
+    std::multimap<QString, QAction *> m_terms;
+    QHash<QKeySequence, QList<QAction *>> m_actionsByShortcut;
+    quint64 m_revision = 0;
+};
+
+/*!
+ * The tree of KShortcutsEditor: a row per action collection, optionally containing a row
+ * per KActionCategory, containing the rows of the actions.
+ *
+ * Rows are appended, and removed when their action is destroyed. Sorting and filtering is
+ * done by KShortcutsEditorProxyModel. The KShortcutsEditorItem of an action row is only
+ * created when the row is needed, e.g. when it is shown, so that huge action collections
+ * can be added quickly. The name of the action is known without the item.
+ *
+ * \internal
+ */
+class KShortcutsEditorModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    explicit KShortcutsEditorModel(QObject *parent = nullptr);
+    ~KShortcutsEditorModel() override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    //! Returns the (collection or category) row called \a title below \a parent, appends it if needed
+    QModelIndex findOrMakeGroup(const QModelIndex &parent, const QString &title);
+    //! Appends rows for \a actions below the group row \a parent
+    void appendActions(const QModelIndex &parent, const QList<QAction *> &actions);
+    void clear();
+
+    //! All actions, in no particular order
+    QList<QAction *> actions() const;
+    //! The items created so far, the other actions can't have changes
+    const QList<KShortcutsEditorItem *> &items() const
+    {
+        return m_items;
+    }
+
+    //! The action of the row \a index (of this model), \c nullptr for other rows
+    QAction *action(const QModelIndex &index) const;
+
+    const KShortcutsEditorSearchIndex &searchIndex() const
+    {
+        return m_searchIndex;
+    }
+
+    //! The item of the action row \a index (of this model), created if needed, \c nullptr for other rows
+    KShortcutsEditorItem *item(const QModelIndex &index) const;
+    KShortcutsEditorItem *item(QAction *action) const;
+
+    //! Updates the view after the item of \a action changed
+    void itemChanged(QAction *action);
+
+    //! Maps \a index of a view showing this model (through proxy models) to this model
+    static QModelIndex sourceIndex(const QModelIndex &index);
+
+private:
+    struct Node {
+        Node *parent = nullptr;
+        int row = 0;
+        //! What the Name column shows, so that sorting doesn't need the items
+        QString title;
+        //! For action rows
+        QAction *action = nullptr;
+        std::unique_ptr<KShortcutsEditorItem> item;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    Node *nodeFromIndex(const QModelIndex &index) const;
+    QModelIndex indexForNode(Node *node, int column = 0) const;
+    KShortcutsEditorItem *itemForNode(Node *node) const;
+    //! Drops the row of \a action, which is being destroyed
+    void removeAction(QAction *action);
+
+    Node m_root;
+    QHash<QAction *, Node *> m_actionNodes;
+    mutable QList<KShortcutsEditorItem *> m_items;
+    KShortcutsEditorSearchIndex m_searchIndex;
+};
+
+/*!
+ * Sorts the rows of KShortcutsEditorModel naturally, and filters them by the search line,
+ * using KShortcutsEditorSearchIndex.
+ *
+ * \internal
+ */
+class KShortcutsEditorProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit KShortcutsEditorProxyModel(QObject *parent = nullptr);
+
+    void setSearchText(const QString &text);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private:
     QCollator m_collator;
+    QString m_searchText;
+    //! The result of the search, for the revision of the index
+    mutable QSet<QAction *> m_matches;
+    mutable std::optional<quint64> m_matchesRevision;
 };
 
 // NEEDED FOR KShortcutsEditorPrivate
@@ -313,11 +508,11 @@ public:
     explicit KShortcutsEditorPrivate(KShortcutsEditor *qq);
 
     void initGUI(KShortcutsEditor::ActionTypes actionTypes, KShortcutsEditor::LetterShortcuts allowLetterShortcuts);
-    void appendToView(uint nList, const QString &title = QString());
-    // used in appendToView
-    QTreeWidgetItem *findOrMakeItem(QTreeWidgetItem *parent, const QString &name);
 
-    static KShortcutsEditorItem *itemFromIndex(QTreeWidget *const w, const QModelIndex &index);
+    //! The item of the action row \a index of the view, \c nullptr for other rows
+    static KShortcutsEditorItem *itemFromIndex(const QModelIndex &index);
+    //! Whether the name of the action row \a index of the view is shown in bold
+    static void setNameBold(const QModelIndex &index, bool bold);
 
     // Set all shortcuts to their default values (bindings).
     void allDefault();
@@ -328,20 +523,16 @@ public:
     // conflict resolution functions
     void changeKeyShortcut(KShortcutsEditorItem *item, uint column, const QKeySequence &capture);
 
-    //! Represents the three hierarchies the dialog handles.
-    struct HierarchyInfo {
-        QTreeWidgetItem *root = nullptr;
-        QTreeWidgetItem *program = nullptr;
-        QTreeWidgetItem *action = nullptr;
-    };
-
     /*!
-     * Add \a action at \a level. Checks for QActions and unnamed actions
-     * before adding.
+     * Checks whether \a action should be shown, i.e. whether it has a name and
+     * configurable shortcuts.
      *
-     * Returns \c true if the action was really added, \c false if not
+     * Returns \c true if the action is to be added, \c false if not
      */
-    bool addAction(QAction *action, QTreeWidgetItem *parent);
+    bool acceptAction(QAction *action);
+
+    //! Expands \a index of the model and its child groups in the view
+    void expandGroup(const QModelIndex &index);
 
     void printShortcuts() const;
 
@@ -359,6 +550,8 @@ public: // members
 
     KShortcutsEditor::ActionTypes actionTypes;
     KShortcutsEditorDelegate *delegate;
+    KShortcutsEditorModel *model = nullptr;
+    KShortcutsEditorProxyModel *proxyModel = nullptr;
 
     // Tracks if there are any local shortcuts in any of the action collections shown in the dialog
     bool m_hasAnyLocalShortcuts = false;
@@ -366,6 +559,4 @@ public: // members
     bool m_hasAnyGlobalShortcuts = false;
 };
 
-Q_DECLARE_METATYPE(KShortcutsEditorItem *)
-
 #endif /* KSHORTCUTSDIALOG_P_H */
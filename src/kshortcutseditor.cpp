@@ -22,6 +22,7 @@
 
 #include <QAction>
 #include <QHeaderView>
+#include <QLineEdit>
 #include <QList>
 #include <QObject>
 #include <QPrintDialog>
@@ -32,6 +33,9 @@
 #include <QTextTableFormat>
 #include <QTimer>
 
+#include <algorithm>
+#include <functional>
+
 #include <KConfig>
 #include <KConfigGroup>
 #if HAVE_GLOBALACCEL
@@ -39,7 +43,6 @@
 #endif
 #include "kactioncategory.h"
 #include "kactioncollection.h"
-#include <KTreeWidgetSearchLine>
 
 //---------------------------------------------------------------------
 // KShortcutsEditor
@@ -68,22 +71,17 @@ KShortcutsEditor::~KShortcutsEditor()
 
 bool KShortcutsEditor::isModified() const
 {
-    // Iterate over all items
-    QTreeWidgetItemIterator it(d->ui.list, QTreeWidgetItemIterator::NoChildren);
-
-    for (; (*it); ++it) {
-        KShortcutsEditorItem *item = dynamic_cast<KShortcutsEditorItem *>(*it);
-        if (item && item->isModified()) {
-            return true;
-        }
-    }
-    return false;
+    // Only the items created so far can have changes
+    const QList<KShortcutsEditorItem *> &items = d->model->items();
+    return std::any_of(items.cbegin(), items.cend(), [](const KShortcutsEditorItem *item) {
+        return item->isModified();
+    });
 }
 
 void KShortcutsEditor::clearCollections()
 {
     d->delegate->contractAll();
-    d->ui.list->clear();
+    d->model->clear();
     d->actionCollections.clear();
     QTimer::singleShot(0, this, &KShortcutsEditor::resizeColumns);
 }
@@ -110,10 +108,7 @@ void KShortcutsEditor::addCollection(KActionCollection *collection, const QStrin
         displayTitle = collection->componentDisplayName();
     }
 
-    KShortcutsEditorPrivate::HierarchyInfo hierarchy;
-    hierarchy.root = d->ui.list->invisibleRootItem();
-    hierarchy.program = d->findOrMakeItem(hierarchy.root, displayTitle);
-    hierarchy.action = nullptr;
+    const QModelIndex program = d->model->findOrMakeGroup(QModelIndex(), displayTitle);
 
     // Set to remember which actions we have seen.
     QSet<QAction *> actionsSeen;
@@ -121,28 +116,36 @@ void KShortcutsEditor::addCollection(KActionCollection *collection, const QStrin
     // Add all categories in their own subtree below the collections root node
     const QList<KActionCategory *> categories = collection->findChildren<KActionCategory *>();
     for (KActionCategory *category : categories) {
-        hierarchy.action = d->findOrMakeItem(hierarchy.program, category->text());
+        const QModelIndex categoryGroup = d->model->findOrMakeGroup(program, category->text());
+        QList<QAction *> actions;
         const auto categoryActions = category->actions();
         for (QAction *action : categoryActions) {
             // Set a marker that we have seen this action
             actionsSeen.insert(action);
-            d->addAction(action, hierarchy.action);
+            if (d->acceptAction(action)) {
+                actions.append(action);
+            }
         }
+        d->model->appendActions(categoryGroup, actions);
     }
 
     // The rest of the shortcuts are added as direct children of the action
     // collections root node
+    QList<QAction *> actions;
     const auto collectionActions = collection->actions();
     for (QAction *action : collectionActions) {
         if (actionsSeen.contains(action)) {
             continue;
         }
 
-        d->addAction(action, hierarchy.program);
+        if (d->acceptAction(action)) {
+            actions.append(action);
+        }
     }
+    d->model->appendActions(program, actions);
 
-    // sort the list
-    d->ui.list->sortItems(Name, Qt::AscendingOrder);
+    // The proxy model sorts the new rows into the existing ones, no need to sort everything again
+    d->expandGroup(program);
 
     // Hide Global shortcuts columns if there are no global shortcuts
     d->setGlobalColumnsHidden(!d->m_hasAnyGlobalShortcuts);
@@ -195,7 +198,7 @@ void KShortcutsEditor::writeConfiguration(KConfigGroup *config) const
 void KShortcutsEditor::resizeColumns()
 {
     // skip Name column as its section resize mode will take care of resizing to contents
-    for (int i = Name + 1; i < d->ui.list->columnCount(); i++) {
+    for (int i = Name + 1; i < d->model->columnCount(); i++) {
         if (d->ui.list->isColumnHidden(i)) {
             continue;
         }
@@ -210,10 +213,9 @@ void KShortcutsEditor::save()
     // undone on deletion! That would lead to weird problems. Changes to
     // Global Shortcuts would vanish completely. Changes to local shortcuts
     // would vanish for this session.
-    for (QTreeWidgetItemIterator it(d->ui.list); (*it); ++it) {
-        if (KShortcutsEditorItem *item = dynamic_cast<KShortcutsEditorItem *>(*it)) {
-            item->commit();
-        }
+    const QList<KShortcutsEditorItem *> &items = d->model->items();
+    for (KShortcutsEditorItem *item : items) {
+        item->commit();
     }
 }
 
@@ -222,9 +224,11 @@ void KShortcutsEditor::undo()
     // This function used to crash sometimes when invoked by clicking on "cancel"
     // with Qt 4.2.something. Apparently items were deleted too early by Qt.
     // It seems to work with 4.3-ish Qt versions. Keep an eye on this.
-    for (QTreeWidgetItemIterator it(d->ui.list); (*it); ++it) {
-        if (KShortcutsEditorItem *item = dynamic_cast<KShortcutsEditorItem *>(*it)) {
+    const QList<KShortcutsEditorItem *> &items = d->model->items();
+    for (KShortcutsEditorItem *item : items) {
+        if (item->isModified()) {
             item->undo();
+            d->model->itemChanged(item->action());
         }
     }
 }
@@ -268,7 +272,27 @@ void KShortcutsEditorPrivate::initGUI(KShortcutsEditor::ActionTypes types, KShor
 
     ui.setupUi(q);
     q->layout()->setContentsMargins(0, 0, 0, 0);
-    ui.searchFilter->searchLine()->setTreeWidget(ui.list); // Plug into search line
+
+    model = new KShortcutsEditorModel(q);
+    proxyModel = new KShortcutsEditorProxyModel(q);
+    proxyModel->setSourceModel(model);
+    ui.list->setModel(proxyModel);
+    ui.list->sortByColumn(Name, Qt::AscendingOrder);
+
+    // Plug into search line
+    QObject::connect(ui.searchFilter, &QLineEdit::textChanged, q, [this](const QString &text) {
+        proxyModel->setSearchText(text);
+    });
+    // Groups which were filtered out come back collapsed, the ones the user collapsed are left alone
+    QObject::connect(proxyModel, &QAbstractItemModel::rowsInserted, q, [this](const QModelIndex &parent, int first, int last) {
+        for (int row = first; row <= last; ++row) {
+            const QModelIndex index = proxyModel->index(row, Name, parent);
+            if (proxyModel->hasChildren(index)) {
+                expandGroup(proxyModel->mapToSource(index));
+            }
+        }
+    });
+
     ui.list->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
     ui.list->header()->hideSection(ShapeGesture); // mouse gestures didn't make it in time...
     ui.list->header()->hideSection(RockerGesture);
@@ -292,7 +316,7 @@ void KShortcutsEditorPrivate::initGUI(KShortcutsEditor::ActionTypes types, KShor
 
     // Create the Delegate. It is responsible for the KKeySeqeunceWidgets that
     // really change the shortcuts.
-    delegate = new KShortcutsEditorDelegate(ui.list, patterns);
+    delegate = new KShortcutsEditorDelegate(ui.list, model, patterns);
 
     ui.list->setItemDelegate(delegate);
     ui.list->setSelectionBehavior(QAbstractItemView::SelectItems);
@@ -308,15 +332,15 @@ void KShortcutsEditorPrivate::initGUI(KShortcutsEditor::ActionTypes types, KShor
             return;
         }
         int column = index.column();
-        KShortcutsEditorItem *item = itemFromIndex(ui.list, index);
+        KShortcutsEditorItem *item = itemFromIndex(index);
         Q_ASSERT(item);
 
         if (column >= LocalPrimary && column <= GlobalAlternate) {
             changeKeyShortcut(item, column, newShortcut);
         }
     });
-    // hide the editor widget chen its item becomes hidden
-    QObject::connect(ui.searchFilter->searchLine(), &KTreeWidgetSearchLine::hiddenChanged, delegate, &KShortcutsEditorDelegate::hiddenBySearchLine);
+    // hide the editor widget when its item becomes hidden
+    QObject::connect(proxyModel, &QAbstractItemModel::rowsAboutToBeRemoved, delegate, &KShortcutsEditorDelegate::rowsAboutToBeRemoved);
 
     ui.searchFilter->setFocus();
 }
@@ -347,7 +371,7 @@ void KShortcutsEditorPrivate::setActionTypes(KShortcutsEditor::ActionTypes types
     setLocalColumnsHidden(!(actionTypes & ~KShortcutsEditor::GlobalAction));
 }
 
-bool KShortcutsEditorPrivate::addAction(QAction *action, QTreeWidgetItem *parent)
+bool KShortcutsEditorPrivate::acceptAction(QAction *action)
 {
     // If the action name starts with unnamed- spit out a warning and ignore
     // it. That name will change at will and will break loading and writing
@@ -359,8 +383,6 @@ bool KShortcutsEditorPrivate::addAction(QAction *action, QTreeWidgetItem *parent
 
     const QVariant value = action->property("isShortcutConfigurable");
     if (!value.isValid() || value.toBool()) {
-        new KShortcutsEditorItem(parent, action);
-
 #if HAVE_GLOBALACCEL
         if (!m_hasAnyGlobalShortcuts) { // If one global action was found, skip
             m_hasAnyGlobalShortcuts = KGlobalAccel::self()->hasShortcut(action);
@@ -379,18 +401,25 @@ bool KShortcutsEditorPrivate::addAction(QAction *action, QTreeWidgetItem *parent
     return false;
 }
 
-void KShortcutsEditorPrivate::allDefault()
+void KShortcutsEditorPrivate::expandGroup(const QModelIndex &index)
 {
-    for (QTreeWidgetItemIterator it(ui.list); (*it); ++it) {
-        if (!(*it)->parent() || (*it)->type() != ActionItem) {
-            continue;
+    ui.list->expand(proxyModel->mapFromSource(index));
+    for (int row = 0; row < model->rowCount(index); ++row) {
+        const QModelIndex child = model->index(row, Name, index);
+        if (model->hasChildren(child)) {
+            ui.list->expand(proxyModel->mapFromSource(child));
         }
+    }
+}
 
-        KShortcutsEditorItem *item = static_cast<KShortcutsEditorItem *>(*it);
-        QAction *act = item->m_action;
-
+void KShortcutsEditorPrivate::allDefault()
+{
+    // Only create the items of the actions which are actually changed
+    const QList<QAction *> actions = model->actions();
+    for (QAction *act : actions) {
         QList<QKeySequence> defaultShortcuts = act->property("defaultShortcuts").value<QList<QKeySequence>>();
         if (act->shortcuts() != defaultShortcuts) {
+            KShortcutsEditorItem *item = model->item(act);
             QKeySequence primary = defaultShortcuts.isEmpty() ? QKeySequence() : defaultShortcuts.at(0);
             QKeySequence alternate = defaultShortcuts.size() <= 1 ? QKeySequence() : defaultShortcuts.at(1);
             changeKeyShortcut(item, LocalPrimary, primary);
@@ -399,6 +428,7 @@ void KShortcutsEditorPrivate::allDefault()
 
 #if HAVE_GLOBALACCEL
         if (KGlobalAccel::self()->shortcut(act) != KGlobalAccel::self()->defaultShortcut(act)) {
+            KShortcutsEditorItem *item = model->item(act);
             QList<QKeySequence> defaultShortcut = KGlobalAccel::self()->defaultShortcut(act);
             changeKeyShortcut(item, GlobalPrimary, primarySequence(defaultShortcut));
             changeKeyShortcut(item, GlobalAlternate, alternateSequence(defaultShortcut));
@@ -408,28 +438,22 @@ void KShortcutsEditorPrivate::allDefault()
 }
 
 // static
-KShortcutsEditorItem *KShortcutsEditorPrivate::itemFromIndex(QTreeWidget *const w, const QModelIndex &index)
+KShortcutsEditorItem *KShortcutsEditorPrivate::itemFromIndex(const QModelIndex &index)
 {
-    QTreeWidgetItem *item = w->itemFromIndex(index);
-    if (item && item->type() == ActionItem) {
-        return static_cast<KShortcutsEditorItem *>(item);
-    }
-    return nullptr;
+    const QModelIndex sourceIndex = KShortcutsEditorModel::sourceIndex(index);
+    const auto *model = qobject_cast<const KShortcutsEditorModel *>(sourceIndex.model());
+    return model ? model->item(sourceIndex) : nullptr;
 }
 
-QTreeWidgetItem *KShortcutsEditorPrivate::findOrMakeItem(QTreeWidgetItem *parent, const QString &name)
+// static
+void KShortcutsEditorPrivate::setNameBold(const QModelIndex &index, bool bold)
 {
-    for (int i = 0; i < parent->childCount(); i++) {
-        QTreeWidgetItem *child = parent->child(i);
-        if (child->text(0) == name) {
-            return child;
-        }
+    const QModelIndex sourceIndex = KShortcutsEditorModel::sourceIndex(index);
+    auto *model = const_cast<KShortcutsEditorModel *>(qobject_cast<const KShortcutsEditorModel *>(sourceIndex.model()));
+    if (KShortcutsEditorItem *item = model ? model->item(sourceIndex) : nullptr) {
+        item->setNameBold(bold);
+        model->itemChanged(item->action());
     }
-    QTreeWidgetItem *ret = new QTreeWidgetItem(parent, NonActionItem);
-    ret->setText(0, name);
-    ui.list->expandItem(ret);
-    ret->setFlags(ret->flags() & ~Qt::ItemIsSelectable);
-    return ret;
 }
 
 // private slot
@@ -443,7 +467,7 @@ void KShortcutsEditorPrivate::changeKeyShortcut(KShortcutsEditorItem *item, uint
     item->setKeySequence(column, capture);
     Q_EMIT q->keyChange();
     // force view update
-    item->setText(column, capture.toString(QKeySequence::NativeText));
+    model->itemChanged(item->action());
 }
 
 void KShortcutsEditorPrivate::importConfiguration(KConfigBase *config)
@@ -453,19 +477,18 @@ void KShortcutsEditorPrivate::importConfiguration(KConfigBase *config)
         return;
     }
 
+    // the id of an action is its object name
+    const QList<QAction *> actions = model->actions();
+
     KConfigGroup globalShortcutsGroup(config, QStringLiteral("Global Shortcuts"));
     if ((actionTypes & KShortcutsEditor::GlobalAction) && globalShortcutsGroup.exists()) {
-        for (QTreeWidgetItemIterator it(ui.list); (*it); ++it) {
-            if (!(*it)->parent()) {
-                continue;
-            }
-
-            KShortcutsEditorItem *item = static_cast<KShortcutsEditorItem *>(*it);
-            const QString actionId = item->data(Id).toString();
+        for (QAction *action : actions) {
+            const QString actionId = action->objectName();
             if (!globalShortcutsGroup.hasKey(actionId)) {
                 continue;
             }
 
+            KShortcutsEditorItem *item = model->item(action);
             QList<QKeySequence> sc = QKeySequence::listFromString(globalShortcutsGroup.readEntry(actionId, QString()));
             changeKeyShortcut(item, GlobalPrimary, primarySequence(sc));
             changeKeyShortcut(item, GlobalAlternate, alternateSequence(sc));
@@ -474,16 +497,13 @@ void KShortcutsEditorPrivate::importConfiguration(KConfigBase *config)
 
     if (actionTypes & ~KShortcutsEditor::GlobalAction) {
         const KConfigGroup localShortcutsGroup(config, QStringLiteral("Shortcuts"));
-        for (QTreeWidgetItemIterator it(ui.list); (*it); ++it) {
-            if (!(*it)->parent()) {
-                continue;
-            }
-            KShortcutsEditorItem *item = static_cast<KShortcutsEditorItem *>(*it);
-            const QString actionId = item->data(Id).toString();
+        for (QAction *action : actions) {
+            const QString actionId = action->objectName();
             if (!localShortcutsGroup.hasKey(actionId)) {
                 continue;
             }
 
+            KShortcutsEditorItem *item = model->item(action);
             QList<QKeySequence> sc = QKeySequence::listFromString(localShortcutsGroup.readEntry(actionId, QString()));
             changeKeyShortcut(item, LocalPrimary, primarySequence(sc));
             changeKeyShortcut(item, LocalAlternate, alternateSequence(sc));
@@ -513,7 +533,37 @@ void KShortcutsEditorPrivate::printShortcuts() const
 {
 // One can't print on wince
 #ifndef _WIN32_WCE
-    QTreeWidgetItem *root = ui.list->invisibleRootItem();
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseSensitive);
+
+    // The rows below parent sorted by name, including those hidden by the search line
+    auto sortedRows = [this, &collator](const QModelIndex &parent) {
+        QList<QModelIndex> rows;
+        const int rowCount = model->rowCount(parent);
+        rows.reserve(rowCount);
+        for (int row = 0; row < rowCount; ++row) {
+            rows.append(model->index(row, Name, parent));
+        }
+        std::sort(rows.begin(), rows.end(), [&collator](const QModelIndex &left, const QModelIndex &right) {
+            return collator.compare(left.data().toString(), right.data().toString()) < 0;
+        });
+        return rows;
+    };
+
+    // The items of the actions below parent, in the order of the (unfiltered) view
+    std::function<void(const QModelIndex &, QList<KShortcutsEditorItem *> &)> collectItems;
+    collectItems = [this, &sortedRows, &collectItems](const QModelIndex &parent, QList<KShortcutsEditorItem *> &items) {
+        const QList<QModelIndex> rows = sortedRows(parent);
+        for (const QModelIndex &index : rows) {
+            if (KShortcutsEditorItem *item = model->item(index)) {
+                items.append(item);
+            } else {
+                collectItems(index, items);
+            }
+        }
+    };
+
     QTextDocument doc;
 
     doc.setDefaultFont(QFontDatabase::systemFont(QFontDatabase::GeneralFont));
@@ -549,10 +599,10 @@ void KShortcutsEditorPrivate::printShortcuts() const
         {i18n("Global alternate:"), GlobalAlternate},
     };
 
-    for (int i = 0; i < root->childCount(); i++) {
-        QTreeWidgetItem *item = root->child(i);
+    const QList<QModelIndex> collectionRows = sortedRows(QModelIndex());
+    for (const QModelIndex &collectionRow : collectionRows) {
         cursor.insertBlock(componentBlockFormat, componentFormat);
-        cursor.insertText(item->text(0));
+        cursor.insertText(collectionRow.data().toString());
 
         QTextTable *table = cursor.insertTable(1, 3);
         table->setFormat(tableformat);
@@ -573,12 +623,9 @@ void KShortcutsEditorPrivate::printShortcuts() const
         cell.firstCursorPosition().insertText(i18n("Description"));
         currow++;
 
-        for (QTreeWidgetItemIterator it(item); *it; ++it) {
-            if ((*it)->type() != ActionItem) {
-                continue;
-            }
-
-            KShortcutsEditorItem *editoritem = static_cast<KShortcutsEditorItem *>(*it);
+        QList<KShortcutsEditorItem *> editorItems;
+        collectItems(collectionRow, editorItems);
+        for (KShortcutsEditorItem *editoritem : std::as_const(editorItems)) {
             table->insertRows(table->rows(), 1);
             QVariant data = editoritem->data(Name, Qt::DisplayRole);
             table->cellAt(currow, 0).firstCursorPosition().insertText(data.toString());
@@ -19,10 +19,10 @@
 #include <QKeyEvent>
 #include <QLabel>
 #include <QPainter>
-#include <QTreeWidgetItemIterator>
 
-KShortcutsEditorDelegate::KShortcutsEditorDelegate(QTreeWidget *parent, KKeySequenceRecorder::Patterns patterns)
+KShortcutsEditorDelegate::KShortcutsEditorDelegate(QTreeView *parent, KShortcutsEditorModel *model, KKeySequenceRecorder::Patterns patterns)
     : KExtendableItemDelegate(parent)
+    , m_model(model)
     , m_patterns(patterns)
 {
     Q_ASSERT(qobject_cast<QAbstractItemView *>(parent));
@@ -61,32 +61,27 @@ KShortcutsEditorDelegate::KShortcutsEditorDelegate(QTreeWidget *parent, KKeySequ
 
 void KShortcutsEditorDelegate::stealShortcut(const QKeySequence &seq, QAction *action)
 {
-    QTreeWidget *view = static_cast<QTreeWidget *>(parent());
-
-    // Iterate over all items
-    QTreeWidgetItemIterator it(view, QTreeWidgetItemIterator::NoChildren);
-
-    for (; (*it); ++it) {
-        KShortcutsEditorItem *item = dynamic_cast<KShortcutsEditorItem *>(*it);
-        if (item && item->data(0, ObjectRole).value<QObject *>() == action) {
-            // We found the action, snapshot the current state. Steal the
-            // shortcut. We will save the change later.
-            const QList<QKeySequence> cut = action->shortcuts();
-            const QKeySequence primary = cut.isEmpty() ? QKeySequence() : cut.at(0);
-            const QKeySequence alternate = cut.size() <= 1 ? QKeySequence() : cut.at(1);
-
-            if (primary.matches(seq) != QKeySequence::NoMatch //
-                || seq.matches(primary) != QKeySequence::NoMatch) {
-                item->setKeySequence(LocalPrimary, QKeySequence());
-            }
+    KShortcutsEditorItem *item = m_model->item(action);
+    if (!item) {
+        return;
+    }
 
-            if (alternate.matches(seq) != QKeySequence::NoMatch //
-                || seq.matches(alternate) != QKeySequence::NoMatch) {
-                item->setKeySequence(LocalAlternate, QKeySequence());
-            }
-            break;
-        }
+    // We found the action, snapshot the current state. Steal the
+    // shortcut. We will save the change later.
+    const QList<QKeySequence> cut = action->shortcuts();
+    const QKeySequence primary = cut.isEmpty() ? QKeySequence() : cut.at(0);
+    const QKeySequence alternate = cut.size() <= 1 ? QKeySequence() : cut.at(1);
+
+    if (primary.matches(seq) != QKeySequence::NoMatch //
+        || seq.matches(primary) != QKeySequence::NoMatch) {
+        item->setKeySequence(LocalPrimary, QKeySequence());
+    }
+
+    if (alternate.matches(seq) != QKeySequence::NoMatch //
+        || seq.matches(alternate) != QKeySequence::NoMatch) {
+        item->setKeySequence(LocalAlternate, QKeySequence());
     }
+    m_model->itemChanged(action);
 }
 
 QSize KShortcutsEditorDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
@@ -99,13 +94,13 @@ QSize KShortcutsEditorDelegate::sizeHint(const QStyleOptionViewItem &option, con
 // slot
 void KShortcutsEditorDelegate::itemActivated(const QModelIndex &_index)
 {
-    // As per our constructor our parent *is* a QTreeWidget
-    QTreeWidget *view = static_cast<QTreeWidget *>(parent());
+    // As per our constructor our parent *is* a QTreeView
+    QTreeView *view = static_cast<QTreeView *>(parent());
     QModelIndex index(_index);
 
-    KShortcutsEditorItem *item = KShortcutsEditorPrivate::itemFromIndex(view, index);
+    KShortcutsEditorItem *item = KShortcutsEditorPrivate::itemFromIndex(index);
     if (!item) {
-        // that probably was a non-leaf (type() !=ActionItem) item
+        // that probably was a collection or category row
         return;
     }
 
@@ -132,10 +127,9 @@ void KShortcutsEditorDelegate::itemActivated(const QModelIndex &_index)
     if (!isExtended(index)) {
         // we only want maximum ONE extender open at any time.
         if (m_editingIndex.isValid()) {
-            KShortcutsEditorItem *oldItem = KShortcutsEditorPrivate::itemFromIndex(view, m_editingIndex);
-            Q_ASSERT(oldItem); // here we really expect nothing but a real KShortcutsEditorItem
+            Q_ASSERT(KShortcutsEditorPrivate::itemFromIndex(m_editingIndex)); // here we really expect nothing but a real KShortcutsEditorItem
 
-            oldItem->setNameBold(false);
+            KShortcutsEditorPrivate::setNameBold(m_editingIndex, false);
             contractItem(m_editingIndex);
         }
 
@@ -189,12 +183,12 @@ void KShortcutsEditorDelegate::itemActivated(const QModelIndex &_index)
         }
 
         m_editor->installEventFilter(this);
-        item->setNameBold(true);
+        KShortcutsEditorPrivate::setNameBold(index, true);
         extendItem(m_editor, index);
 
     } else {
         // the item is extended, and clicking on it again closes it
-        item->setNameBold(false);
+        KShortcutsEditorPrivate::setNameBold(index, false);
         contractItem(index);
         view->selectionModel()->select(index, QItemSelectionModel::Clear);
         m_editingIndex = QModelIndex();
@@ -222,15 +216,14 @@ void KShortcutsEditorDelegate::itemCollapsed(const QModelIndex &index)
 }
 
 // slot
-void KShortcutsEditorDelegate::hiddenBySearchLine(QTreeWidgetItem *item, bool hidden)
+void KShortcutsEditorDelegate::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
 {
-    if (!hidden || !item) {
-        return;
-    }
-    QTreeWidget *view = static_cast<QTreeWidget *>(parent());
-    QTreeWidgetItem *editingItem = KShortcutsEditorPrivate::itemFromIndex(view, m_editingIndex);
-    if (editingItem == item) {
-        itemActivated(m_editingIndex); // this will *close* the item's editor because it's already open
+    // the row being edited, or one of its parents, might be removed
+    for (QModelIndex index = m_editingIndex; index.isValid(); index = index.parent()) {
+        if (index.parent() == parent && index.row() >= first && index.row() <= last) {
+            itemActivated(m_editingIndex); // this will *close* the item's editor because it's already open
+            return;
+        }
     }
 }
 
@@ -260,7 +253,7 @@ bool KShortcutsEditorDelegate::eventFilter(QObject *o, QEvent *e)
             return false;
         }
         QKeyEvent *ke = static_cast<QKeyEvent *>(e);
-        QTreeWidget *view = static_cast<QTreeWidget *>(parent());
+        QTreeView *view = static_cast<QTreeView *>(parent());
         QItemSelectionModel *selection = view->selectionModel();
         QModelIndex index = selection->currentIndex();
 
@@ -17,27 +17,28 @@
 #include "kshortcutsdialog_p.h"
 
 #include <QAction>
-#include <QTreeWidgetItem>
 
 #if HAVE_GLOBALACCEL
 #include <KGlobalAccel>
 #endif
 
-KShortcutsEditorItem::KShortcutsEditorItem(QTreeWidgetItem *parent, QAction *action)
-    : QTreeWidgetItem(parent, ActionItem)
-    , m_action(action)
+KShortcutsEditorItem::KShortcutsEditorItem(QAction *action)
+    : m_action(action)
     , m_isNameBold(false)
 {
-    // Filtering message requested by translators (scripting).
     m_id = m_action->objectName();
-    m_actionNameInTable = i18nc("@item:intable Action name in shortcuts configuration", "%1", KLocalizedString::removeAcceleratorMarker(m_action->text()));
-    if (m_actionNameInTable.isEmpty()) {
+    m_actionNameInTable = actionNameInTable(m_action);
+    if (KLocalizedString::removeAcceleratorMarker(m_action->text()).isEmpty()) {
         qCWarning(DEBUG_KXMLGUI) << "Action without text!" << m_action->objectName();
-        m_actionNameInTable = m_id;
     }
+}
 
-    m_collator.setNumericMode(true);
-    m_collator.setCaseSensitivity(Qt::CaseSensitive);
+// static
+QString KShortcutsEditorItem::actionNameInTable(const QAction *action)
+{
+    // Filtering message requested by translators (scripting).
+    const QString name = i18nc("@item:intable Action name in shortcuts configuration", "%1", KLocalizedString::removeAcceleratorMarker(action->text()));
+    return name.isEmpty() ? action->objectName() : name;
 }
 
 KShortcutsEditorItem::~KShortcutsEditorItem() = default;
@@ -47,6 +48,26 @@ bool KShortcutsEditorItem::isModified() const
     return m_oldLocalShortcut || m_oldGlobalShortcut;
 }
 
+const KShortcutsEditorItem::Cache &KShortcutsEditorItem::cache() const
+{
+    if (!m_cache) {
+        Cache cache;
+        cache.shortcuts = m_action->shortcuts();
+        cache.defaultShortcuts = m_action->property("defaultShortcuts").value<QList<QKeySequence>>();
+        const QVariant configurable = m_action->property("isShortcutConfigurable");
+        cache.isConfigurable = !configurable.isValid() || configurable.toBool();
+#if HAVE_GLOBALACCEL
+        cache.hasGlobalShortcut = KGlobalAccel::self()->hasShortcut(m_action);
+        if (cache.hasGlobalShortcut) {
+            cache.globalShortcuts = KGlobalAccel::self()->shortcut(m_action);
+            cache.defaultGlobalShortcuts = KGlobalAccel::self()->defaultShortcut(m_action);
+        }
+#endif
+        m_cache = std::move(cache);
+    }
+    return *m_cache;
+}
+
 QVariant KShortcutsEditorItem::data(int column, int role) const
 {
     switch (role) {
@@ -79,7 +100,8 @@ QVariant KShortcutsEditorItem::data(int column, int role) const
         return QVariant();
     case Qt::FontRole:
         if (column == Name && m_isNameBold) {
-            QFont modifiedFont = treeWidget()->font();
+            // resolved against the font of the view
+            QFont modifiedFont;
             modifiedFont.setBold(true);
             return modifiedFont;
         }
@@ -90,15 +112,11 @@ QVariant KShortcutsEditorItem::data(int column, int role) const
             return false;
         case LocalPrimary:
         case LocalAlternate:
-            return !m_action->property("isShortcutConfigurable").isValid() //
-                || m_action->property("isShortcutConfigurable").toBool();
+            return cache().isConfigurable;
 #if HAVE_GLOBALACCEL
         case GlobalPrimary:
         case GlobalAlternate:
-            if (!KGlobalAccel::self()->hasShortcut(m_action)) {
-                return false;
-            }
-            return true;
+            return cache().hasGlobalShortcut;
 #endif
         default:
             return false;
@@ -118,21 +136,17 @@ QVariant KShortcutsEditorItem::data(int column, int role) const
         }
 
     case DefaultShortcutRole: {
-        QList<QKeySequence> defaultShortcuts = m_action->property("defaultShortcuts").value<QList<QKeySequence>>();
-#if HAVE_GLOBALACCEL
-        QList<QKeySequence> defaultGlobalShortcuts = KGlobalAccel::self()->defaultShortcut(m_action);
-#endif
-
+        const Cache &c = cache();
         switch (column) {
         case LocalPrimary:
-            return primarySequence(defaultShortcuts);
+            return primarySequence(c.defaultShortcuts);
         case LocalAlternate:
-            return alternateSequence(defaultShortcuts);
+            return alternateSequence(c.defaultShortcuts);
 #if HAVE_GLOBALACCEL
         case GlobalPrimary:
-            return primarySequence(defaultGlobalShortcuts);
+            return primarySequence(c.defaultGlobalShortcuts);
         case GlobalAlternate:
-            return alternateSequence(defaultGlobalShortcuts);
+            return alternateSequence(c.defaultGlobalShortcuts);
 #endif
         default:
             // Column not valid for this role
@@ -150,34 +164,18 @@ QVariant KShortcutsEditorItem::data(int column, int role) const
     return QVariant();
 }
 
-bool KShortcutsEditorItem::operator<(const QTreeWidgetItem &other) const
-{
-    const int column = treeWidget() ? treeWidget()->sortColumn() : 0;
-    return m_collator.compare(text(column), other.text(column)) < 0;
-}
-
 QKeySequence KShortcutsEditorItem::keySequence(uint column) const
 {
-    auto shortcuts = [this]() {
-        return m_action->shortcuts();
-    };
-
-#if HAVE_GLOBALACCEL
-    auto globalShortcuts = [this]() {
-        return KGlobalAccel::self()->shortcut(m_action);
-    };
-#endif
-
     switch (column) {
     case LocalPrimary:
-        return primarySequence(shortcuts());
+        return primarySequence(cache().shortcuts);
     case LocalAlternate:
-        return alternateSequence(shortcuts());
+        return alternateSequence(cache().shortcuts);
 #if HAVE_GLOBALACCEL
     case GlobalPrimary:
-        return primarySequence(globalShortcuts());
+        return primarySequence(cache().globalShortcuts);
     case GlobalAlternate:
-        return alternateSequence(globalShortcuts());
+        return alternateSequence(cache().globalShortcuts);
 #endif
     default:
         return QKeySequence();
@@ -231,6 +229,7 @@ void KShortcutsEditorItem::setKeySequence(uint column, const QKeySequence &seq)
         m_action->setShortcuts(ks);
     }
 
+    invalidate();
     updateModified();
 }
 
@@ -292,6 +291,7 @@ void KShortcutsEditorItem::undo()
     }
 #endif
 
+    invalidate();
     updateModified();
 }
 
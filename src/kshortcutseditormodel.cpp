@@ -0,0 +1,523 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "config-xmlgui.h"
+
+#include "kshortcutsdialog_p.h"
+
+#include <QAbstractProxyModel>
+#include <QAction>
+#include <QRegularExpression>
+
+#include <KFuzzyMatcher>
+#if HAVE_GLOBALACCEL
+#include <KGlobalAccel>
+#endif
+#include <KLocalizedString>
+
+#include <algorithm>
+
+void KShortcutsEditorSearchIndex::addAction(QAction *action)
+{
+    if (m_entries.contains(action)) {
+        return;
+    }
+
+    const Entry entry = entryForAction(action);
+    insertEntry(action, entry);
+    m_entries.insert(action, entry);
+    ++m_revision;
+}
+
+void KShortcutsEditorSearchIndex::updateAction(QAction *action)
+{
+    const auto it = m_entries.find(action);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    Entry entry = entryForAction(action);
+    // QAction::changed is emitted for much more than text and shortcut changes
+    if (entry.terms == it->terms && entry.shortcuts == it->shortcuts) {
+        return;
+    }
+
+    removeEntry(action, *it);
+    insertEntry(action, entry);
+    *it = std::move(entry);
+    ++m_revision;
+}
+
+void KShortcutsEditorSearchIndex::removeAction(QAction *action)
+{
+    const auto it = m_entries.find(action);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    removeEntry(action, *it);
+    m_entries.erase(it);
+    ++m_revision;
+}
+
+void KShortcutsEditorSearchIndex::clear()
+{
+    m_entries.clear();
+    m_terms.clear();
+    m_actionsByShortcut.clear();
+    ++m_revision;
+}
+
+QSet<QAction *> KShortcutsEditorSearchIndex::search(const QString &text) const
+{
+    QSet<QAction *> actions;
+    const QString query = text.trimmed().toLower();
+    if (query.isEmpty()) {
+        return actions;
+    }
+
+    // All terms starting with query are in one range
+    for (auto it = m_terms.lower_bound(query); it != m_terms.cend() && it->first.startsWith(query); ++it) {
+        actions.insert(it->second);
+    }
+
+    // e.g. "shift+ctrl+k", which doesn't have to be written like the shortcut is shown
+    QKeySequence sequence = QKeySequence::fromString(text.trimmed(), QKeySequence::PortableText);
+    if (sequence.isEmpty()) {
+        sequence = QKeySequence::fromString(text.trimmed(), QKeySequence::NativeText);
+    }
+    bool isKeySequence = !sequence.isEmpty();
+    for (int i = 0; i < sequence.count(); ++i) {
+        isKeySequence = isKeySequence && sequence[i].key() != Qt::Key_unknown;
+    }
+    if (isKeySequence) {
+        const QList<QAction *> shortcutActions = m_actionsByShortcut.value(sequence);
+        for (QAction *action : shortcutActions) {
+            actions.insert(action);
+        }
+    }
+
+    // Fuzzy matching is a scan of all actions, and would only add noise to the matches
+    // found so far. Shorter texts would match almost everything.
+    if (actions.isEmpty() && query.size() >= 3) {
+        for (auto entryIt = m_entries.cbegin(); entryIt != m_entries.cend(); ++entryIt) {
+            if (KFuzzyMatcher::matchSimple(query, entryIt->name)) {
+                actions.insert(entryIt.key());
+            }
+        }
+    }
+
+    return actions;
+}
+
+// static
+KShortcutsEditorSearchIndex::Entry KShortcutsEditorSearchIndex::entryForAction(QAction *action)
+{
+    Entry entry;
+    entry.name = KLocalizedString::removeAcceleratorMarker(action->text()).toLower();
+
+    // "Configure Keyboard Shortcuts" and "options_configure_keybinding" are
+    // also found by "keyboard" and "keybinding"
+    static const QRegularExpression separators(QStringLiteral("[\\W_]+"));
+    auto addTerms = [&entry](const QString &text) {
+        if (text.isEmpty()) {
+            return;
+        }
+        entry.terms.append(text);
+        const QStringList words = text.split(separators, Qt::SkipEmptyParts);
+        if (words.size() > 1) {
+            entry.terms.append(words);
+        }
+    };
+    addTerms(entry.name);
+    const QString text = action->text().toLower();
+    if (text != entry.name) {
+        entry.terms.append(text);
+    }
+    addTerms(action->objectName().toLower());
+
+    entry.shortcuts = action->shortcuts();
+#if HAVE_GLOBALACCEL
+    if (KGlobalAccel::self()->hasShortcut(action)) {
+        entry.shortcuts.append(KGlobalAccel::self()->shortcut(action));
+    }
+#endif
+    entry.shortcuts.removeAll(QKeySequence());
+    for (const QKeySequence &shortcut : std::as_const(entry.shortcuts)) {
+        const QString nativeText = shortcut.toString(QKeySequence::NativeText).toLower();
+        const QString portableText = shortcut.toString(QKeySequence::PortableText).toLower();
+        entry.terms.append(nativeText);
+        if (portableText != nativeText) {
+            entry.terms.append(portableText);
+        }
+    }
+
+    entry.terms.removeDuplicates();
+    return entry;
+}
+
+void KShortcutsEditorSearchIndex::insertEntry(QAction *action, const Entry &entry)
+{
+    for (const QString &term : entry.terms) {
+        m_terms.emplace(term, action);
+    }
+
+    for (const QKeySequence &shortcut : entry.shortcuts) {
+        QList<QAction *> &actions = m_actionsByShortcut[shortcut];
+        if (!actions.contains(action)) {
+            actions.append(action);
+        }
+    }
+}
+
+void KShortcutsEditorSearchIndex::removeEntry(QAction *action, const Entry &entry)
+{
+    // only looks at the actions sharing the terms of the action
+    for (const QString &term : entry.terms) {
+        auto [it, end] = m_terms.equal_range(term);
+        it = std::find_if(it, end, [action](const std::pair<const QString, QAction *> &termAction) {
+            return termAction.second == action;
+        });
+        if (it != end) {
+            m_terms.erase(it);
+        }
+    }
+
+    for (const QKeySequence &shortcut : entry.shortcuts) {
+        const auto it = m_actionsByShortcut.find(shortcut);
+        if (it == m_actionsByShortcut.end()) {
+            continue;
+        }
+        it->removeOne(action);
+        if (it->isEmpty()) {
+            m_actionsByShortcut.erase(it);
+        }
+    }
+}
+
+KShortcutsEditorModel::KShortcutsEditorModel(QObject *parent)
+    : QAbstractItemModel(parent)
+{
+#if HAVE_GLOBALACCEL
+    // the items cache the global shortcuts, which can be changed from elsewhere (e.g. System Settings)
+    connect(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged, this, [this](QAction *action) {
+        if (m_actionNodes.contains(action)) {
+            m_searchIndex.updateAction(action);
+            itemChanged(action);
+        }
+    });
+#endif
+}
+
+KShortcutsEditorModel::~KShortcutsEditorModel() = default;
+
+QModelIndex KShortcutsEditorModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const Node *parentNode = nodeFromIndex(parent);
+    if (row < 0 || column < 0 || column >= columnCount() || row >= int(parentNode->children.size())) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, parentNode->children[row].get());
+}
+
+QModelIndex KShortcutsEditorModel::parent(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
+    return indexForNode(static_cast<Node *>(index.internalPointer())->parent);
+}
+
+int KShortcutsEditorModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+    return int(nodeFromIndex(parent)->children.size());
+}
+
+int KShortcutsEditorModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    // Id is not shown
+    return ShapeGesture + 1;
+}
+
+QVariant KShortcutsEditorModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    Node *node = static_cast<Node *>(index.internalPointer());
+    // the proxy model sorts by it, that must not create the items of all rows
+    if (index.column() == Name && role == Qt::DisplayRole) {
+        return node->title;
+    }
+    if (!node->action) {
+        return QVariant();
+    }
+    return itemForNode(node)->data(index.column(), role);
+}
+
+QVariant KShortcutsEditorModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case Name:
+        return i18n("Action");
+    case LocalPrimary:
+        return i18n("Shortcut");
+    case LocalAlternate:
+        return i18n("Alternate");
+    case GlobalPrimary:
+        return i18n("Global");
+    case GlobalAlternate:
+        return i18n("Global Alternate");
+    case RockerGesture:
+        return i18n("Mouse Button Gesture");
+    case ShapeGesture:
+        return i18n("Mouse Shape Gesture");
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags KShortcutsEditorModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    if (!static_cast<Node *>(index.internalPointer())->action) {
+        return Qt::ItemIsEnabled;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+QModelIndex KShortcutsEditorModel::findOrMakeGroup(const QModelIndex &parent, const QString &title)
+{
+    Node *parentNode = nodeFromIndex(parent);
+    for (const auto &child : parentNode->children) {
+        if (!child->action && child->title == title) {
+            return indexForNode(child.get());
+        }
+    }
+
+    const int row = int(parentNode->children.size());
+    beginInsertRows(parent, row, row);
+    auto node = std::make_unique<Node>();
+    node->parent = parentNode;
+    node->row = row;
+    node->title = title;
+    parentNode->children.push_back(std::move(node));
+    endInsertRows();
+
+    return index(row, 0, parent);
+}
+
+void KShortcutsEditorModel::appendActions(const QModelIndex &parent, const QList<QAction *> &actions)
+{
+    if (actions.isEmpty()) {
+        return;
+    }
+
+    Node *parentNode = nodeFromIndex(parent);
+    const int first = int(parentNode->children.size());
+    beginInsertRows(parent, first, first + int(actions.size()) - 1);
+    parentNode->children.reserve(first + actions.size());
+    for (QAction *action : actions) {
+        auto node = std::make_unique<Node>();
+        node->parent = parentNode;
+        node->row = int(parentNode->children.size());
+        node->action = action;
+        node->title = KShortcutsEditorItem::actionNameInTable(action);
+        m_actionNodes.insert(action, node.get());
+        parentNode->children.push_back(std::move(node));
+        m_searchIndex.addAction(action);
+
+        // e.g. when a shortcut is stolen through KKeySequenceWidget
+        connect(action, &QAction::changed, this, [this, action]() {
+            if (Node *node = m_actionNodes.value(action)) {
+                node->title = KShortcutsEditorItem::actionNameInTable(action);
+            }
+            m_searchIndex.updateAction(action);
+            itemChanged(action);
+        });
+        connect(action, &QObject::destroyed, this, [this, action]() {
+            removeAction(action);
+        });
+    }
+    endInsertRows();
+}
+
+void KShortcutsEditorModel::clear()
+{
+    beginResetModel();
+    for (QAction *action : m_actionNodes.keys()) {
+        disconnect(action, nullptr, this, nullptr);
+    }
+    m_root.children.clear();
+    m_actionNodes.clear();
+    m_items.clear();
+    m_searchIndex.clear();
+    endResetModel();
+}
+
+QList<QAction *> KShortcutsEditorModel::actions() const
+{
+    return m_actionNodes.keys();
+}
+
+KShortcutsEditorItem *KShortcutsEditorModel::item(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return nullptr;
+    }
+    Q_ASSERT(index.model() == this);
+
+    Node *node = static_cast<Node *>(index.internalPointer());
+    return node->action ? itemForNode(node) : nullptr;
+}
+
+QAction *KShortcutsEditorModel::action(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return nullptr;
+    }
+    Q_ASSERT(index.model() == this);
+
+    // unlike item(), doesn't create the item
+    return static_cast<Node *>(index.internalPointer())->action;
+}
+
+KShortcutsEditorItem *KShortcutsEditorModel::item(QAction *action) const
+{
+    Node *node = m_actionNodes.value(action);
+    return node ? itemForNode(node) : nullptr;
+}
+
+void KShortcutsEditorModel::itemChanged(QAction *action)
+{
+    Node *node = m_actionNodes.value(action);
+    if (!node) {
+        return;
+    }
+
+    if (node->item) {
+        node->item->invalidate();
+    }
+    // also when there is no item yet, the proxy model might have to filter the row again
+    Q_EMIT dataChanged(indexForNode(node, 0), indexForNode(node, columnCount() - 1));
+}
+
+// static
+QModelIndex KShortcutsEditorModel::sourceIndex(const QModelIndex &index)
+{
+    QModelIndex sourceIndex = index;
+    while (auto proxyModel = qobject_cast<const QAbstractProxyModel *>(sourceIndex.model())) {
+        sourceIndex = proxyModel->mapToSource(sourceIndex);
+    }
+    return sourceIndex;
+}
+
+KShortcutsEditorModel::Node *KShortcutsEditorModel::nodeFromIndex(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return const_cast<Node *>(&m_root);
+    }
+    return static_cast<Node *>(index.internalPointer());
+}
+
+QModelIndex KShortcutsEditorModel::indexForNode(Node *node, int column) const
+{
+    if (!node || node == &m_root) {
+        return QModelIndex();
+    }
+    return createIndex(node->row, column, node);
+}
+
+void KShortcutsEditorModel::removeAction(QAction *action)
+{
+    Node *node = m_actionNodes.take(action);
+    if (!node) {
+        return;
+    }
+
+    Node *parentNode = node->parent;
+    const int row = node->row;
+    beginRemoveRows(indexForNode(parentNode), row, row);
+    if (node->item) {
+        m_items.removeOne(node->item.get());
+    }
+    m_searchIndex.removeAction(action);
+    parentNode->children.erase(parentNode->children.begin() + row);
+    for (int i = row; i < int(parentNode->children.size()); ++i) {
+        parentNode->children[i]->row = i;
+    }
+    endRemoveRows();
+}
+
+KShortcutsEditorItem *KShortcutsEditorModel::itemForNode(Node *node) const
+{
+    if (!node->item) {
+        node->item = std::make_unique<KShortcutsEditorItem>(node->action);
+        m_items.append(node->item.get());
+    }
+    return node->item.get();
+}
+
+KShortcutsEditorProxyModel::KShortcutsEditorProxyModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    m_collator.setNumericMode(true);
+    m_collator.setCaseSensitivity(Qt::CaseSensitive);
+
+    // show the matching rows with all their parents, and all children of matching groups
+    setRecursiveFilteringEnabled(true);
+    setAutoAcceptChildRows(true);
+}
+
+void KShortcutsEditorProxyModel::setSearchText(const QString &text)
+{
+    if (text == m_searchText) {
+        return;
+    }
+
+    m_searchText = text;
+    m_matchesRevision.reset();
+    invalidateFilter();
+}
+
+bool KShortcutsEditorProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (m_searchText.trimmed().isEmpty()) {
+        return true;
+    }
+
+    auto model = static_cast<const KShortcutsEditorModel *>(sourceModel());
+    const QModelIndex index = model->index(sourceRow, 0, sourceParent);
+    QAction *action = model->action(index);
+    if (!action) {
+        return index.data().toString().contains(m_searchText.trimmed(), Qt::CaseInsensitive);
+    }
+
+    // one lookup in the index for all rows, instead of matching the text of each row
+    const KShortcutsEditorSearchIndex &searchIndex = model->searchIndex();
+    if (m_matchesRevision != searchIndex.revision()) {
+        m_matches = searchIndex.search(m_searchText);
+        m_matchesRevision = searchIndex.revision();
+    }
+    return m_matches.contains(action);
+}
+
+bool KShortcutsEditorProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    return m_collator.compare(left.data().toString(), right.data().toString()) < 0;
+}
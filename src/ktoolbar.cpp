@@ -33,6 +33,7 @@
 #include <KAuthorized>
 #include <KConfig>
 #include <KConfigGroup>
+#include <KConfigWatcher>
 #include <KIconTheme>
 #include <KLocalizedString>
 #include <KSharedConfig>
@@ -42,6 +43,7 @@
 
 #include "kactioncollection.h"
 #include "kedittoolbar.h"
+#include "kxmlguiconfigfile_p.h"
 #include "kxmlguifactory.h"
 #include "kxmlguiwindow.h"
 
@@ -135,7 +137,9 @@ public:
     QString getPositionAsString() const;
     QMenu *contextMenu(const QPoint &globalPos);
     void setLocked(bool locked);
+    void scheduleSeparatorVisibilityAdjustment();
     void adjustSeparatorVisibility();
+    static bool filterEditEvent(QObject *watched, QEvent *event);
     void loadKDESettings();
     void applyCurrentSettings();
 
@@ -144,15 +148,16 @@ public:
     static Qt::ToolButtonStyle toolButtonStyleFromString(const QString &style);
     static QString toolButtonStyleToString(Qt::ToolButtonStyle);
     static Qt::ToolBarArea positionFromString(const QString &position);
-    static Qt::ToolButtonStyle toolButtonStyleSetting();
 
 public:
     KToolBar *const q;
 
     bool isMainToolBar : 1;
     bool unlockedMovable : 1;
+    bool separatorAdjustmentScheduled = false;
     static bool s_editable;
     static bool s_locked;
+    static QPointer<QObject> s_editFilter;
 
     QSet<KXMLGUIClient *> xmlguiClients;
 
@@ -242,10 +247,140 @@ public:
 
 bool KToolBarPrivate::s_editable = false;
 bool KToolBarPrivate::s_locked = true;
+QPointer<QObject> KToolBarPrivate::s_editFilter;
+
+/*
+ * Redirects the mouse events of the widgets in all toolbars to the toolbars while they are
+ * editable, so that the actions can be dragged around. A single filter on the application,
+ * installed only while editing, instead of filters on every widget and all its children.
+ */
+class KToolBarEditFilter : public QObject
+{
+public:
+    using QObject::QObject;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        return KToolBarPrivate::filterEditEvent(watched, event);
+    }
+};
+
+/*
+ * The KDE-global toolbar settings, shared by all toolbars, so that creating many toolbars
+ * (e.g. when restoring a session with many windows) doesn't read them over and over again.
+ * Exists as long as there are toolbars. When the settings change, they are read once and
+ * applied to all toolbars.
+ */
+class KToolBarStyleSettings : public QObject
+{
+    Q_OBJECT
+public:
+    static KToolBarStyleSettings *self()
+    {
+        return s_self;
+    }
+    static void addToolBar(KToolBarPrivate *toolBar);
+    static void removeToolBar(KToolBarPrivate *toolBar);
+
+    Qt::ToolButtonStyle mainToolBarStyle = Qt::ToolButtonTextBesideIcon;
+    Qt::ToolButtonStyle otherToolBarsStyle = Qt::ToolButtonTextBesideIcon;
+    int mainToolBarIconSize = 0;
+    int toolBarIconSize = 0;
+
+private Q_SLOTS:
+    void slotStyleChanged();
+
+private:
+    KToolBarStyleSettings();
+    void load();
+
+    QList<KToolBarPrivate *> m_toolBars;
+    KConfigWatcher::Ptr m_watcher;
+
+    static KToolBarStyleSettings *s_self;
+};
+
+KToolBarStyleSettings *KToolBarStyleSettings::s_self = nullptr;
+
+KToolBarStyleSettings::KToolBarStyleSettings()
+{
+    load();
+
+#ifdef WITH_QTDBUS
+    QDBusConnection::sessionBus()
+        .connect(QString(), QStringLiteral("/KToolBar"), QStringLiteral("org.kde.KToolBar"), QStringLiteral("styleChanged"), this, SLOT(slotStyleChanged()));
+#endif
+    connect(KIconLoader::global(), &KIconLoader::iconLoaderSettingsChanged, this, &KToolBarStyleSettings::slotStyleChanged);
+
+    m_watcher = KConfigWatcher::create(KSharedConfig::openConfig());
+    connect(m_watcher.data(), &KConfigWatcher::configChanged, this, [this](const KConfigGroup &group) {
+        if (group.name() == QLatin1String("Toolbar style")) {
+            slotStyleChanged();
+        }
+    });
+}
+
+void KToolBarStyleSettings::addToolBar(KToolBarPrivate *toolBar)
+{
+    if (!s_self) {
+        s_self = new KToolBarStyleSettings;
+    }
+    s_self->m_toolBars.append(toolBar);
+}
+
+void KToolBarStyleSettings::removeToolBar(KToolBarPrivate *toolBar)
+{
+    if (!s_self) {
+        return;
+    }
+    s_self->m_toolBars.removeOne(toolBar);
+    if (s_self->m_toolBars.isEmpty()) {
+        // read them again for the next toolbars, not all changes are notified
+        delete s_self;
+        s_self = nullptr;
+    }
+}
+
+void KToolBarStyleSettings::load()
+{
+    KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
+    const QString fallBack = KToolBarPrivate::toolButtonStyleToString(Qt::ToolButtonTextBesideIcon);
+    mainToolBarStyle = KToolBarPrivate::toolButtonStyleFromString(group.readEntry("ToolButtonStyle", fallBack));
+
+    /*
+      TODO: if we get complaints about text beside icons on small screens,
+            try the following code out on such systems - aseigo.
+    // if we are on a small screen with a non-landscape ratio, then
+    // we revert to text under icons since width is probably not our
+    // friend in such cases
+    QDesktopWidget *desktop = QApplication::desktop();
+    QRect screenGeom = desktop->screenGeometry(desktop->primaryScreen());
+    qreal ratio = screenGeom.width() / qreal(screenGeom.height());
+
+    if (screenGeom.width() < 1024 && ratio <= 1.4) {
+        fallBack = "TextUnderIcon";
+    }
+    **/
+    otherToolBarsStyle = KToolBarPrivate::toolButtonStyleFromString(group.readEntry("ToolButtonStyleOtherToolbars", fallBack));
+
+    mainToolBarIconSize = KIconLoader::global()->currentSize(KIconLoader::MainToolbar);
+    toolBarIconSize = KIconLoader::global()->currentSize(KIconLoader::Toolbar);
+}
+
+// Global setting was changed
+void KToolBarStyleSettings::slotStyleChanged()
+{
+    load();
+    for (KToolBarPrivate *toolBar : std::as_const(m_toolBars)) {
+        toolBar->slotAppearanceChanged();
+    }
+}
 
 void KToolBarPrivate::init(bool readConfig, bool _isMainToolBar)
 {
     isMainToolBar = _isMainToolBar;
+    KToolBarStyleSettings::addToolBar(this);
     loadKDESettings();
 
     // also read in our configurable settings (for non-xmlgui toolbars)
@@ -275,13 +410,6 @@ void KToolBarPrivate::init(bool readConfig, bool _isMainToolBar)
 
     q->setAcceptDrops(true);
 
-#ifdef WITH_QTDBUS
-    QDBusConnection::sessionBus()
-        .connect(QString(), QStringLiteral("/KToolBar"), QStringLiteral("org.kde.KToolBar"), QStringLiteral("styleChanged"), q, SLOT(slotAppearanceChanged()));
-#endif
-    QObject::connect(KIconLoader::global(), &KIconLoader::iconLoaderSettingsChanged, q, [this]() {
-        slotAppearanceChanged();
-    });
 }
 
 QString KToolBarPrivate::getPositionAsString() const
@@ -514,13 +642,35 @@ void KToolBarPrivate::setLocked(bool locked)
     }
 }
 
+/*
+ * Adjusting the separators walks all actions, doing that for every action added, removed
+ * or changed would make (re)filling the toolbar quadratic. So all the changes done until
+ * the event loop runs again are handled at once.
+ */
+void KToolBarPrivate::scheduleSeparatorVisibilityAdjustment()
+{
+    if (separatorAdjustmentScheduled) {
+        return;
+    }
+    separatorAdjustmentScheduled = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this]() {
+            adjustSeparatorVisibility();
+        },
+        Qt::QueuedConnection);
+}
+
 void KToolBarPrivate::adjustSeparatorVisibility()
 {
+    separatorAdjustmentScheduled = false;
+
     bool visibleNonSeparator = false;
     int separatorToShow = -1;
 
-    for (int index = 0; index < q->actions().count(); ++index) {
-        QAction *action = q->actions().at(index);
+    const QList<QAction *> actions = q->actions();
+    for (int index = 0; index < actions.count(); ++index) {
+        QAction *action = actions.at(index);
         if (action->isSeparator()) {
             if (visibleNonSeparator) {
                 separatorToShow = index;
@@ -532,7 +682,7 @@ void KToolBarPrivate::adjustSeparatorVisibility()
             if (action->isVisible()) {
                 visibleNonSeparator = true;
                 if (separatorToShow != -1) {
-                    q->actions().at(separatorToShow)->setVisible(true);
+                    actions.at(separatorToShow)->setVisible(true);
                     separatorToShow = -1;
                 }
             }
@@ -540,8 +690,56 @@ void KToolBarPrivate::adjustSeparatorVisibility()
     }
 
     if (separatorToShow != -1) {
-        q->actions().at(separatorToShow)->setVisible(false);
+        actions.at(separatorToShow)->setVisible(false);
+    }
+}
+
+bool KToolBarPrivate::filterEditEvent(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::MouseButtonRelease:
+        break;
+    default:
+        return false;
+    }
+
+    QWidget *widget = qobject_cast<QWidget *>(watched);
+    KToolBar *toolBar = nullptr;
+    for (QWidget *w = widget; w && !w->isWindow(); w = w->parentWidget()) {
+        toolBar = qobject_cast<KToolBar *>(w->parentWidget());
+        if (toolBar) {
+            // only the widgets of the actions, not e.g. the extension button
+            if (toolBar->layout()->indexOf(w) == -1) {
+                return false;
+            }
+            break;
+        }
+    }
+    if (!toolBar) {
+        return false;
+    }
+
+    QMouseEvent *me = static_cast<QMouseEvent *>(event);
+    QMouseEvent newEvent(me->type(),
+                         toolBar->mapFromGlobal(widget->mapToGlobal(me->position().toPoint())),
+                         me->globalPosition().toPoint(),
+                         me->button(),
+                         me->buttons(),
+                         me->modifiers());
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+        toolBar->mousePressEvent(&newEvent);
+        break;
+    case QEvent::MouseMove:
+        toolBar->mouseMoveEvent(&newEvent);
+        break;
+    default:
+        toolBar->mouseReleaseEvent(&newEvent);
+        break;
     }
+    return true;
 }
 
 Qt::ToolButtonStyle KToolBarPrivate::toolButtonStyleFromString(const QString &_style)
@@ -588,47 +786,18 @@ Qt::ToolBarArea KToolBarPrivate::positionFromString(const QString &position)
     return newposition;
 }
 
-// Global setting was changed
+// Global setting was changed, see KToolBarStyleSettings
 void KToolBarPrivate::slotAppearanceChanged()
 {
     loadKDESettings();
     applyCurrentSettings();
 }
 
-Qt::ToolButtonStyle KToolBarPrivate::toolButtonStyleSetting()
-{
-    KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
-    const QString fallback = KToolBarPrivate::toolButtonStyleToString(Qt::ToolButtonTextBesideIcon);
-    return KToolBarPrivate::toolButtonStyleFromString(group.readEntry("ToolButtonStyle", fallback));
-}
-
 void KToolBarPrivate::loadKDESettings()
 {
+    const KToolBarStyleSettings *settings = KToolBarStyleSettings::self();
     iconSizeSettings[Level_KDEDefault] = q->iconSizeDefault();
-
-    if (isMainToolBar) {
-        toolButtonStyleSettings[Level_KDEDefault] = toolButtonStyleSetting();
-    } else {
-        const QString fallBack = toolButtonStyleToString(Qt::ToolButtonTextBesideIcon);
-        /*
-          TODO: if we get complaints about text beside icons on small screens,
-                try the following code out on such systems - aseigo.
-        // if we are on a small screen with a non-landscape ratio, then
-        // we revert to text under icons since width is probably not our
-        // friend in such cases
-        QDesktopWidget *desktop = QApplication::desktop();
-        QRect screenGeom = desktop->screenGeometry(desktop->primaryScreen());
-        qreal ratio = screenGeom.width() / qreal(screenGeom.height());
-
-        if (screenGeom.width() < 1024 && ratio <= 1.4) {
-            fallBack = "TextUnderIcon";
-        }
-        **/
-
-        KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
-        const QString value = group.readEntry("ToolButtonStyleOtherToolbars", fallBack);
-        toolButtonStyleSettings[Level_KDEDefault] = KToolBarPrivate::toolButtonStyleFromString(value);
-    }
+    toolButtonStyleSettings[Level_KDEDefault] = isMainToolBar ? settings->mainToolBarStyle : settings->otherToolBarsStyle;
 }
 
 // Call this after changing something in d->iconSizeSettings or d->toolButtonStyleSettings
@@ -801,10 +970,8 @@ void KToolBarPrivate::slotContextShowText()
     }
 
     // Save the priority state of the action
-    const QString configFile = KXMLGUIFactory::readConfigFile(filename, componentName);
-
     QDomDocument document;
-    document.setContent(configFile);
+    document.setContent(KXmlGuiConfigFile(filename, componentName).data());
     QDomElement elem = KXMLGUIFactory::actionPropertiesElement(document);
     QDomElement actionElem = KXMLGUIFactory::findActionByName(elem, contextButtonAction->objectName(), true);
     actionElem.setAttribute(QStringLiteral("priority"), priority);
@@ -909,6 +1076,7 @@ KToolBar::KToolBar(const QString &objectName, QMainWindow *parent, Qt::ToolBarAr
 
 KToolBar::~KToolBar()
 {
+    KToolBarStyleSettings::removeToolBar(d.get());
     delete d->contextLockAction;
 }
 
@@ -1118,7 +1286,8 @@ void KToolBar::setIconDimensions(int size)
 
 int KToolBar::iconSizeDefault() const
 {
-    return KIconLoader::global()->currentSize(d->isMainToolBar ? KIconLoader::MainToolbar : KIconLoader::Toolbar);
+    const KToolBarStyleSettings *settings = KToolBarStyleSettings::self();
+    return d->isMainToolBar ? settings->mainToolBarIconSize : settings->toolBarIconSize;
 }
 
 void KToolBar::slotMovableChanged(bool movable)
@@ -1334,59 +1503,11 @@ bool KToolBar::eventFilter(QObject *watched, QEvent *event)
         }
 
     } else if (event->type() == QEvent::ParentChange) {
-        // Make sure we're not leaving stale event filters around,
-        // when a child is reparented somewhere else
+        // Make sure we're not leaving a stale event filter around,
+        // when a widget is reparented somewhere else
         if (QWidget *ww = qobject_cast<QWidget *>(watched)) {
-            if (!this->isAncestorOf(ww)) {
-                // New parent is not a subwidget - remove event filter
+            if (ww->parent() != this) {
                 ww->removeEventFilter(this);
-                const auto children = ww->findChildren<QWidget *>();
-                for (QWidget *child : children) {
-                    child->removeEventFilter(this);
-                }
-            }
-        }
-    }
-
-    // Redirect mouse events to the toolbar when drag + drop editing is enabled
-    if (toolBarsEditable()) {
-        if (QWidget *ww = qobject_cast<QWidget *>(watched)) {
-            switch (event->type()) {
-            case QEvent::MouseButtonPress: {
-                QMouseEvent *me = static_cast<QMouseEvent *>(event);
-                QMouseEvent newEvent(me->type(),
-                                     mapFromGlobal(ww->mapToGlobal(me->position().toPoint())),
-                                     me->globalPosition().toPoint(),
-                                     me->button(),
-                                     me->buttons(),
-                                     me->modifiers());
-                mousePressEvent(&newEvent);
-                return true;
-            }
-            case QEvent::MouseMove: {
-                QMouseEvent *me = static_cast<QMouseEvent *>(event);
-                QMouseEvent newEvent(me->type(),
-                                     mapFromGlobal(ww->mapToGlobal(me->position().toPoint())),
-                                     me->globalPosition().toPoint(),
-                                     me->button(),
-                                     me->buttons(),
-                                     me->modifiers());
-                mouseMoveEvent(&newEvent);
-                return true;
-            }
-            case QEvent::MouseButtonRelease: {
-                QMouseEvent *me = static_cast<QMouseEvent *>(event);
-                QMouseEvent newEvent(me->type(),
-                                     mapFromGlobal(ww->mapToGlobal(me->position().toPoint())),
-                                     me->globalPosition().toPoint(),
-                                     me->button(),
-                                     me->buttons(),
-                                     me->modifiers());
-                mouseReleaseEvent(&newEvent);
-                return true;
-            }
-            default:
-                break;
             }
         }
     }
@@ -1396,15 +1517,13 @@ bool KToolBar::eventFilter(QObject *watched, QEvent *event)
 
 void KToolBar::actionEvent(QActionEvent *event)
 {
+    // The filter only watches the widgets of the actions themselves: mouse presses on
+    // disabled children propagate to them. Mouse events are redirected to the toolbar
+    // while editing by KToolBarEditFilter.
     if (event->type() == QEvent::ActionRemoved) {
         QWidget *widget = widgetForAction(event->action());
         if (widget) {
             widget->removeEventFilter(this);
-
-            const auto children = widget->findChildren<QWidget *>();
-            for (QWidget *child : children) {
-                child->removeEventFilter(this);
-            }
         }
     }
 
@@ -1415,10 +1534,6 @@ void KToolBar::actionEvent(QActionEvent *event)
         if (widget) {
             widget->installEventFilter(this);
 
-            const auto children = widget->findChildren<QWidget *>();
-            for (QWidget *child : children) {
-                child->installEventFilter(this);
-            }
             // Center widgets that do not have any use for more space. See bug 165274
             if (!(widget->sizePolicy().horizontalPolicy() & QSizePolicy::GrowFlag)
                 // ... but do not center when using text besides icon in vertical toolbar. See bug 243196
@@ -1431,7 +1546,7 @@ void KToolBar::actionEvent(QActionEvent *event)
         }
     }
 
-    d->adjustSeparatorVisibility();
+    d->scheduleSeparatorVisibilityAdjustment();
 }
 
 bool KToolBar::toolBarsEditable()
@@ -1443,6 +1558,13 @@ void KToolBar::setToolBarsEditable(bool editable)
 {
     if (KToolBarPrivate::s_editable != editable) {
         KToolBarPrivate::s_editable = editable;
+
+        if (editable && !KToolBarPrivate::s_editFilter) {
+            KToolBarPrivate::s_editFilter = new KToolBarEditFilter(qApp);
+            qApp->installEventFilter(KToolBarPrivate::s_editFilter);
+        } else if (!editable) {
+            delete KToolBarPrivate::s_editFilter;
+        }
     }
 }
 
@@ -1474,4 +1596,5 @@ void KToolBar::emitToolbarStyleChanged()
 #endif
 }
 
+#include "ktoolbar.moc"
 #include "moc_ktoolbar.cpp"
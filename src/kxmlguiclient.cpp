@@ -11,22 +11,33 @@
 #include "debug.h"
 #include "kactioncollection.h"
 #include "kxmlguibuilder.h"
+#include "kxmlguiconfigfile_p.h"
+#include "kxmlguidocumentcache_p.h"
 #include "kxmlguifactory.h"
 #include "kxmlguiversionhandler_p.h"
 #include "utils_p.h"
 
 #include <QAction>
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QDomDocument>
 #include <QFile>
+#include <QFuture>
+#include <QHash>
 #include <QPointer>
+#include <QPromise>
 #include <QStandardPaths>
+#include <QThreadPool>
 
 #include <KAuthorized>
 #include <KLocalizedString>
 
 #include <cassert>
+#include <memory>
+#include <optional>
+#include <typeinfo>
+#include <utility>
 
 class KXMLGUIClientPrivate
 {
@@ -40,10 +51,26 @@ public:
     {
     }
 
+    // The action lookups done while merging, the same actions usually appear several times
+    struct MergeContext {
+        KActionCollection *actionCollection;
+        QHash<QString, bool> implementedActions;
+        QHash<QString, bool> usableActions; // implemented and authorized
+    };
+
     bool mergeXML(QDomElement &base, QDomElement &additive, KActionCollection *actionCollection);
-    bool isEmptyContainer(const QDomElement &base, KActionCollection *actionCollection) const;
+    bool mergeXML(QDomElement &base, QDomElement &additive, MergeContext &context);
+    bool isEmptyContainer(const QDomElement &base, MergeContext &context) const;
+
+    // These are static so that they can run in prepareXMLFile()'s worker thread
+    static QStringList findXMLFiles(const QString &file, const QString &componentName, const QString &localXMLFile);
+    template<typename Data>
+    static bool parseXML(QDomDocument &doc, const Data &document, const QStringList &textTagNames);
 
-    QDomElement findMatchingElement(const QDomElement &base, const QDomElement &additive);
+    bool setFileXML(KXMLGUIClient *client, const QString &xml, bool merge);
+    static QString cacheId(const KXMLGUIClient *client, const QString &file);
+    QString standardsCacheKey(const QString &file) const;
+    QString xmlFileCacheKey(const QStringList &files, bool merge, KActionCollection *actionCollection) const;
 
     QString m_componentName;
 
@@ -58,6 +85,13 @@ public:
     QString m_xmlFile;
     QString m_localXMLFile;
     const QStringList m_textTagNames;
+    // Describes the inputs m_doc was built from, see KXmlGuiDocumentCache.
+    // Empty if m_doc came from somewhere else (setXML, setDOMDocument).
+    QString m_docCacheKey;
+    // The content of the file setFileXML() passes to setXML(), and whether it reached
+    // KXMLGUIClient::setXML() unchanged
+    QString m_fileXML;
+    bool m_fileXMLUnchanged = false;
 
     // Actions to enable/disable on a state change
     QMap<QString, KXMLGUIClient::StateChange> m_actionsStateMap;
@@ -197,7 +231,24 @@ QString KXMLGUIClient::standardsXmlFileLocation()
 
 void KXMLGUIClient::loadStandardsXmlFile()
 {
-    setXML(KXMLGUIFactory::readConfigFile(standardsXmlFileLocation()));
+    const QString file = standardsXmlFileLocation();
+    const QString cacheId = d->cacheId(this, QStringLiteral("ui_standards.rc"));
+    const QString cacheKey = KXmlGuiDocumentCache::isEnabled() ? d->standardsCacheKey(file) : QString();
+    if (!cacheKey.isEmpty()) {
+        const QDomDocument cached = KXmlGuiDocumentCache::load(cacheId, cacheKey);
+        if (!cached.isNull()) {
+            setDOMDocument(cached);
+            d->m_docCacheKey = cacheKey;
+            return;
+        }
+    }
+
+    const bool cacheable = d->setFileXML(this, KXmlGuiConfigFile(file).toString(), false);
+
+    if (cacheable && !cacheKey.isEmpty() && !d->m_doc.isNull()) {
+        KXmlGuiDocumentCache::save(cacheId, cacheKey, d->m_doc);
+        d->m_docCacheKey = cacheKey;
+    }
 }
 
 void KXMLGUIClient::setXMLFile(const QString &_file, bool merge, bool setXMLDoc)
@@ -212,11 +263,44 @@ void KXMLGUIClient::setXMLFile(const QString &_file, bool merge, bool setXMLDoc)
     }
 
     QString file = _file;
+    const QStringList allFiles = KXMLGUIClientPrivate::findXMLFiles(file, componentName(), d->m_localXMLFile);
+
+    // The cache holds the result of the version handling, the parsing and the merging below
+    const QString cacheId = d->cacheId(this, componentName() + QLatin1Char('/') + _file + (merge ? QStringLiteral("+merge") : QString()));
+    const QString cacheKey = KXmlGuiDocumentCache::isEnabled() && !allFiles.isEmpty() ? d->xmlFileCacheKey(allFiles, merge, actionCollection()) : QString();
+    if (!cacheKey.isEmpty()) {
+        const QDomDocument cached = KXmlGuiDocumentCache::load(cacheId, cacheKey);
+        if (!cached.isNull()) {
+            setDOMDocument(cached);
+            d->m_docCacheKey = cacheKey;
+            return;
+        }
+    }
+
+    QString xml;
+    if (allFiles.count() == 1) {
+        // No versions to compare, the file is mapped instead of being read
+        xml = KXmlGuiConfigFile(allFiles.first()).toString();
+    } else if (!allFiles.isEmpty()) {
+        file = findMostRecentXMLFile(allFiles, xml);
+    }
+
+    // Always call setXML, even on error, so that we don't keep all ui_standards.rc menus.
+    const bool cacheable = d->setFileXML(this, xml, merge);
+
+    if (cacheable && !cacheKey.isEmpty() && !d->m_doc.isNull()) {
+        KXmlGuiDocumentCache::save(cacheId, cacheKey, d->m_doc);
+        d->m_docCacheKey = cacheKey;
+    }
+}
+
+QStringList KXMLGUIClientPrivate::findXMLFiles(const QString &file, const QString &componentName, const QString &localXMLFile)
+{
     QStringList allFiles;
     if (!QDir::isRelativePath(file)) {
         allFiles.append(file);
     } else {
-        const QString filter = componentName() + QLatin1Char('/') + _file;
+        const QString filter = componentName + QLatin1Char('/') + file;
 
         // files on filesystem
         allFiles << QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("kxmlgui5/") + filter);
@@ -227,27 +311,59 @@ void KXMLGUIClient::setXMLFile(const QString &_file, bool merge, bool setXMLDoc)
             allFiles << qrcFile;
         }
     }
-    if (allFiles.isEmpty() && !_file.isEmpty()) {
+    if (allFiles.isEmpty() && !file.isEmpty()) {
         // if a non-empty file gets passed and we can't find it,
         // inform the developer using some debug output
-        qCWarning(DEBUG_KXMLGUI) << "cannot find .rc file" << _file << "for component" << componentName();
+        qCWarning(DEBUG_KXMLGUI) << "cannot find .rc file" << file << "for component" << componentName;
     }
 
     // make sure to merge the settings from any file specified by setLocalXMLFile()
-    if (!d->m_localXMLFile.isEmpty() && !file.endsWith(QLatin1String("ui_standards.rc"))) {
-        const bool exists = QDir::isRelativePath(d->m_localXMLFile) || QFile::exists(d->m_localXMLFile);
-        if (exists && !allFiles.contains(d->m_localXMLFile)) {
-            allFiles.prepend(d->m_localXMLFile);
+    if (!localXMLFile.isEmpty() && !file.endsWith(QLatin1String("ui_standards.rc"))) {
+        const bool exists = QDir::isRelativePath(localXMLFile) || QFile::exists(localXMLFile);
+        if (exists && !allFiles.contains(localXMLFile)) {
+            allFiles.prepend(localXMLFile);
         }
     }
+    return allFiles;
+}
 
-    QString doc;
-    if (!allFiles.isEmpty()) {
-        file = findMostRecentXMLFile(allFiles, doc);
-    }
+QFuture<QDomDocument> KXMLGUIClient::prepareXMLFile(const QString &file) const
+{
+    auto promise = std::make_shared<QPromise<QDomDocument>>();
+    QFuture<QDomDocument> future = promise->future();
+    promise->start();
+
+    const QString componentName = this->componentName();
+    const QString localXMLFile = d->m_localXMLFile;
+    const QStringList textTagNames = d->m_textTagNames;
+    QThreadPool::globalInstance()->start([promise, file, componentName, localXMLFile, textTagNames]() {
+        QDomDocument doc;
+        const QStringList allFiles = KXMLGUIClientPrivate::findXMLFiles(file, componentName, localXMLFile);
+        // Same as in setXMLFile(), errors result in a null document
+        if (allFiles.count() == 1) {
+            if (!KXMLGUIClientPrivate::parseXML(doc, KXmlGuiConfigFile(allFiles.first()).data(), textTagNames)) {
+                doc = QDomDocument();
+            }
+        } else if (!allFiles.isEmpty()) {
+            QString xml;
+            findMostRecentXMLFile(allFiles, xml);
+            if (!KXMLGUIClientPrivate::parseXML(doc, xml, textTagNames)) {
+                doc = QDomDocument();
+            }
+        }
+        promise->addResult(doc);
+        promise->finish();
+    });
 
-    // Always call setXML, even on error, so that we don't keep all ui_standards.rc menus.
-    setXML(doc, merge);
+    return future;
+}
+
+void KXMLGUIClient::setPreparedXMLFile(const QString &file, const QDomDocument &document, bool merge)
+{
+    if (!file.isNull()) {
+        d->m_xmlFile = file;
+    }
+    setDOMDocument(document, merge);
 }
 
 void KXMLGUIClient::setLocalXMLFile(const QString &file)
@@ -265,6 +381,17 @@ void KXMLGUIClient::replaceXMLFile(const QString &xmlfile, const QString &localx
     setXMLFile(xmlfile, merge);
 }
 
+// Returns the element following \a element in document order within \a root,
+// or a null element when all of them were visited
+static QDomElement nextElement(const QDomElement &element, const QDomElement &root)
+{
+    QDomElement next = element.firstChildElement();
+    for (QDomElement e = element; next.isNull() && e != root; e = e.parentNode().toElement()) {
+        next = e.nextSiblingElement();
+    }
+    return next;
+}
+
 // The top document element may have translation domain attribute set,
 // or the translation domain may be implicitly the application domain.
 // This domain must be used to fetch translations for all text elements
@@ -283,21 +410,18 @@ static void propagateTranslationDomain(QDomDocument &doc, const QStringList &tag
             return;
         }
     }
-    for (const QString &tagName : tagNames) {
-        QDomNodeList textNodes = base.elementsByTagName(tagName);
-        for (int i = 0; i < textNodes.length(); ++i) {
-            QDomElement e = textNodes.item(i).toElement();
-            QString localDomain = e.attribute(attrDomain);
-            if (localDomain.isEmpty()) {
-                e.setAttribute(attrDomain, domain);
-            }
+    // Visit all elements once, rather than once per tag name with elementsByTagName()
+    for (QDomElement e = nextElement(base, base); !e.isNull(); e = nextElement(e, base)) {
+        if (tagNames.contains(e.tagName()) && e.attribute(attrDomain).isEmpty()) {
+            e.setAttribute(attrDomain, domain);
         }
     }
 }
 
-void KXMLGUIClient::setXML(const QString &document, bool merge)
+// Parses either a QString or the (UTF-8) data of a file, see KXmlGuiConfigFile
+template<typename Data>
+bool KXMLGUIClientPrivate::parseXML(QDomDocument &doc, const Data &document, const QStringList &textTagNames)
 {
-    QDomDocument doc;
     // QDomDocument raises a parse error on empty document, but we accept no app-specific document,
     // in which case you only get ui_standards.rc layout.
     if (!document.isEmpty()) {
@@ -305,18 +429,37 @@ void KXMLGUIClient::setXML(const QString &document, bool merge)
         if (!result) {
             qCCritical(DEBUG_KXMLGUI) << "Error parsing XML document:" << result.errorMessage << "at line" << result.errorLine << "column"
                                       << result.errorColumn;
-            setDOMDocument(QDomDocument(), merge); // otherwise empty menus from ui_standards.rc stay around
-            return;
+            return false;
         }
     }
 
-    propagateTranslationDomain(doc, d->m_textTagNames);
+    propagateTranslationDomain(doc, textTagNames);
+    return true;
+}
+
+void KXMLGUIClient::setXML(const QString &document, bool merge)
+{
+    if (document == d->m_fileXML) {
+        d->m_fileXMLUnchanged = true;
+    }
+
+    QDomDocument doc;
+    if (!d->parseXML(doc, document, d->m_textTagNames)) {
+        setDOMDocument(QDomDocument(), merge); // otherwise empty menus from ui_standards.rc stay around
+        return;
+    }
     setDOMDocument(doc, merge);
 }
 
 void KXMLGUIClient::setDOMDocument(const QDomDocument &document, bool merge)
 {
+    d->m_docCacheKey.clear();
+
     if (merge && !d->m_doc.isNull()) {
+        if (d->m_factory) {
+            // the factory still needs the document the GUI was built from, see KXMLGUIFactory::updateClients()
+            d->m_doc = d->m_doc.cloneNode(true).toDocument();
+        }
         QDomElement base = d->m_doc.documentElement();
 
         QDomElement e = document.documentElement();
@@ -341,7 +484,130 @@ void KXMLGUIClient::setDOMDocument(const QDomDocument &document, bool merge)
     setXMLGUIBuildDocument(QDomDocument());
 }
 
+/*
+ * Passes the content of an xmlgui file to setXML(). Returns whether it reached
+ * KXMLGUIClient::setXML() unchanged, only then the resulting document may be cached:
+ * reimplementations of setXML() might post-process the XML, they have to see it.
+ */
+bool KXMLGUIClientPrivate::setFileXML(KXMLGUIClient *client, const QString &xml, bool merge)
+{
+    m_fileXML = xml;
+    m_fileXMLUnchanged = false;
+    client->setXML(xml, merge);
+    m_fileXML.clear();
+    return std::exchange(m_fileXMLUnchanged, false);
+}
+
+/*
+ * The cache entries are per class of client: they are only written when setXML() doesn't
+ * change the XML, which can then be skipped on cache hits for clients of the same class.
+ */
+// static
+QString KXMLGUIClientPrivate::cacheId(const KXMLGUIClient *client, const QString &file)
+{
+    return QLatin1String(typeid(*client).name()) + QLatin1Char('|') + file;
+}
+
+QString KXMLGUIClientPrivate::standardsCacheKey(const QString &file) const
+{
+    return QString::fromUtf8(KLocalizedString::applicationDomain()) + QLatin1Char('|') + KXmlGuiDocumentCache::fileFingerprint(file);
+}
+
+QString KXMLGUIClientPrivate::xmlFileCacheKey(const QStringList &files, bool merge, KActionCollection *actionCollection) const
+{
+    QString key = QString::fromUtf8(KLocalizedString::applicationDomain());
+    for (const QString &file : files) {
+        key += QLatin1Char('|') + KXmlGuiDocumentCache::fileFingerprint(file);
+    }
+
+    if (merge && !m_doc.isNull()) {
+        if (m_docCacheKey.isEmpty()) {
+            // We don't know what we'd be merging into
+            return QString();
+        }
+
+        // mergeXML() drops the elements for actions which are not in the
+        // collection (or not authorized), so the result depends on those too
+        QStringList actionNames;
+        const auto actions = actionCollection->actions();
+        actionNames.reserve(actions.size());
+        for (const QAction *action : actions) {
+            if (KAuthorized::authorizeAction(action->objectName())) {
+                actionNames.append(action->objectName());
+            }
+        }
+        actionNames.sort();
+        const QByteArray actionsHash = QCryptographicHash::hash(actionNames.join(QLatin1Char('\n')).toUtf8(), QCryptographicHash::Sha1).toHex();
+
+        key += QLatin1String("|actions:") + QLatin1String(actionsHash) + QLatin1String("|base:") + m_docCacheKey;
+    }
+    return key;
+}
+
+/*
+ * Finds the child element of a container that matches a given element, i.e. that has
+ * the same tag name (case insensitive) and name attribute (scheme attribute for
+ * ActionProperties), through a hash built once for all lookups. Action and MergeLocal
+ * children never match.
+ *
+ * Children removed from (or moved out of) the container in the meantime are skipped,
+ * children added to it have to be insert()ed.
+ */
+class MatchingElementIndex
+{
+public:
+    explicit MatchingElementIndex(const QDomElement &container)
+        : m_container(container)
+    {
+        for (QDomElement e = container.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
+            insert(e);
+        }
+    }
+
+    void insert(const QDomElement &element)
+    {
+        const QString tag = element.tagName();
+        // skip all action and merge tags as we will never use them
+        if (equals(tag, "Action") || equals(tag, "MergeLocal")) {
+            return;
+        }
+        m_elements[key(element)].append(element);
+    }
+
+    QDomElement find(const QDomElement &element) const
+    {
+        const auto it = m_elements.constFind(key(element));
+        if (it == m_elements.cend()) {
+            return QDomElement();
+        }
+        // the first one (in document order) still in the container
+        for (const QDomElement &e : *it) {
+            if (e.parentNode() == m_container) {
+                return e;
+            }
+        }
+        return QDomElement();
+    }
+
+private:
+    static std::pair<QString, QString> key(const QDomElement &element)
+    {
+        const QString tag = element.tagName().toLower();
+        const QString idAttribute(tag == QLatin1String("actionproperties") ? QStringLiteral("scheme") : QStringLiteral("name"));
+        return {tag, element.attribute(idAttribute)};
+    }
+
+    const QDomElement m_container;
+    QHash<std::pair<QString, QString>, QList<QDomElement>> m_elements;
+};
+
 bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KActionCollection *actionCollection)
+{
+    MergeContext context{actionCollection, {}, {}};
+    return mergeXML(base, additive, context);
+}
+
+bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, MergeContext &context)
 {
     const std::string_view tagAction("Action");
     const std::string_view tagMerge("Merge");
@@ -375,6 +641,9 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
             }
         }
 
+        // the containers of the local tree, looked up for each container of the global tree
+        std::optional<MatchingElementIndex> additiveIndex;
+
         // iterate over all elements in the container (of the global DOM tree)
         QDomNode n = base.firstChild();
         while (!n.isNull()) {
@@ -390,7 +659,11 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
             // not implemented, then we remove the element
             if (equals(tag, tagAction)) {
                 const QString name = e.attribute(attrName);
-                if (!actionCollection->action(name) || !KAuthorized::authorizeAction(name)) {
+                auto usableIt = context.usableActions.constFind(name);
+                if (usableIt == context.usableActions.cend()) {
+                    usableIt = context.usableActions.insert(name, context.actionCollection->action(name) && KAuthorized::authorizeAction(name));
+                }
+                if (!*usableIt) {
                     // remove this child as we aren't using it
                     base.removeChild(e);
                     continue;
@@ -419,6 +692,7 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
             // of the local tree shall be merged in.  After inserting the
             // elements we delete this element
             else if (equals(tag, tagMergeLocal)) {
+                MatchingElementIndex baseIndex(base);
                 QDomNode it = additive.firstChild();
                 while (!it.isNull()) {
                     QDomElement newChild = it.toElement();
@@ -442,9 +716,10 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
                         // first, see if this new element matches a standard one in
                         // the global file.  if it does, then we skip it as it will
                         // be merged in, later
-                        QDomElement matchingElement = findMatchingElement(newChild, base);
+                        QDomElement matchingElement = baseIndex.find(newChild);
                         if (matchingElement.isNull() || equals(newChild.tagName(), tagSeparator)) {
                             base.insertBefore(newChild, e);
+                            baseIndex.insert(newChild);
                         }
                     }
                 }
@@ -464,11 +739,14 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
             // recursively and delete the just proceeded container item in
             // case it is empty (if the recursive call returns true)
             else {
-                QDomElement matchingElement = findMatchingElement(e, additive);
+                if (!additiveIndex) {
+                    additiveIndex.emplace(additive);
+                }
+                QDomElement matchingElement = additiveIndex->find(e);
                 if (!matchingElement.isNull()) {
                     matchingElement.setAttribute(attrAlreadyVisited, uint(1));
 
-                    if (mergeXML(e, matchingElement, actionCollection)) {
+                    if (mergeXML(e, matchingElement, context)) {
                         base.removeChild(e);
                         additive.removeChild(matchingElement); // make sure we don't append it below
                         continue;
@@ -482,7 +760,7 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
                     // and make it check if there are actions implemented for this
                     // container. *If* none, then we can remove this container now
                     QDomElement dummy;
-                    if (mergeXML(e, dummy, actionCollection)) {
+                    if (mergeXML(e, dummy, context)) {
                         base.removeChild(e);
                     }
                     continue;
@@ -492,6 +770,7 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
 
         // here we append all child elements which were not inserted
         // previously via the LocalMerge tag
+        MatchingElementIndex baseIndex(base);
         n = additive.firstChild();
         while (!n.isNull()) {
             QDomElement e = n.toElement();
@@ -500,10 +779,11 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
                 continue;
             }
 
-            QDomElement matchingElement = findMatchingElement(e, base);
+            QDomElement matchingElement = baseIndex.find(e);
 
             if (matchingElement.isNull()) {
                 base.appendChild(e);
+                baseIndex.insert(e);
             }
         }
 
@@ -515,10 +795,10 @@ bool KXMLGUIClientPrivate::mergeXML(QDomElement &base, QDomElement &additive, KA
         }
     }
 
-    return isEmptyContainer(base, actionCollection);
+    return isEmptyContainer(base, context);
 }
 
-bool KXMLGUIClientPrivate::isEmptyContainer(const QDomElement &base, KActionCollection *actionCollection) const
+bool KXMLGUIClientPrivate::isEmptyContainer(const QDomElement &base, MergeContext &context) const
 {
     // now we check if we are empty (in which case we return "true", to
     // indicate the caller that it can delete "us" (the base element
@@ -537,7 +817,12 @@ bool KXMLGUIClientPrivate::isEmptyContainer(const QDomElement &base, KActionColl
             // if base contains an implemented action, then we must not get
             // deleted (note that the actionCollection contains both,
             // "global" and "local" actions)
-            if (actionCollection->action(e.attribute(QStringLiteral("name")))) {
+            const QString name = e.attribute(QStringLiteral("name"));
+            auto implementedIt = context.implementedActions.constFind(name);
+            if (implementedIt == context.implementedActions.cend()) {
+                implementedIt = context.implementedActions.insert(name, context.actionCollection->action(name) != nullptr);
+            }
+            if (*implementedIt) {
                 return false;
             }
         } else if (equals(tag, "Separator")) {
@@ -571,35 +856,6 @@ bool KXMLGUIClientPrivate::isEmptyContainer(const QDomElement &base, KActionColl
     return true; // I'm empty, please delete me.
 }
 
-QDomElement KXMLGUIClientPrivate::findMatchingElement(const QDomElement &base, const QDomElement &additive)
-{
-    const QString idAttribute(base.tagName() == QLatin1String("ActionProperties") ? QStringLiteral("scheme") : QStringLiteral("name"));
-
-    QDomNode n = additive.firstChild();
-    while (!n.isNull()) {
-        QDomElement e = n.toElement();
-        n = n.nextSibling(); // Advance now so that we can safely delete e -- TODO we don't, so simplify this
-        if (e.isNull()) {
-            continue;
-        }
-
-        const QString tag = e.tagName();
-        // skip all action and merge tags as we will never use them
-        if (equals(tag, "Action") || equals(tag, "MergeLocal")) {
-            continue;
-        }
-
-        // now see if our tags are equivalent
-        if (equals(tag, base.tagName()) //
-            && e.attribute(idAttribute) == base.attribute(idAttribute)) {
-            return e;
-        }
-    }
-
-    // nope, return a (now) null element
-    return QDomElement();
-}
-
 void KXMLGUIClient::setXMLGUIBuildDocument(const QDomDocument &doc)
 {
     d->m_buildDocument = doc;
@@ -13,6 +13,8 @@
 
 #include <QStringList>
 
+template<typename T>
+class QFuture;
 class QDomDocument;
 class QDomElement;
 class QWidget;
@@ -314,6 +316,46 @@ public:
      */
     void replaceXMLFile(const QString &xmlfile, const QString &localxmlfile, bool merge = false);
 
+    /*!
+     * \brief Prepares the document of the rc \a file in a worker thread.
+     *
+     * This does what setXMLFile() does up to the merging with the global
+     * document: finding the files (using the component name and the local xml
+     * file set at the time of the call), handling their version numbers,
+     * reading and parsing. Pass the result to setPreparedXMLFile() in the GUI
+     * thread. This allows preparing the documents of many clients (e.g. plugins)
+     * in parallel, before adding them to a KXMLGUIFactory.
+     *
+     * \code
+     * auto future = plugin->prepareXMLFile(QStringLiteral("pluginui.rc"));
+     * future.then(this, [this, plugin](const QDomDocument &document) {
+     *     plugin->setPreparedXMLFile(QStringLiteral("pluginui.rc"), document, true);
+     *     guiFactory()->addClient(plugin);
+     * });
+     * \endcode
+     *
+     * The result is a null document if no file was found or if parsing failed.
+     *
+     * Include <QFuture> to use the result.
+     *
+     * \sa setPreparedXMLFile()
+     * \since 6.30
+     */
+    QFuture<QDomDocument> prepareXMLFile(const QString &file) const;
+
+    /*!
+     * \brief Sets the \a document returned by prepareXMLFile() for \a file,
+     * and whether to \a merge it with the global document.
+     *
+     * The merging happens here, as it depends on the actions of the client.
+     * Otherwise this is equivalent to setXMLFile(file, merge), without the
+     * file access and parsing. Overrides of setXMLFile() are not called.
+     *
+     * \sa prepareXMLFile()
+     * \since 6.30
+     */
+    void setPreparedXMLFile(const QString &file, const QDomDocument &document, bool merge = false);
+
     /*!
      * \brief Returns the version number of the given \a xml data
      * belonging to an XML rc file.
@@ -361,6 +403,11 @@ protected:
      *
      * Since 5.4, the file will then be assumed to be installed in a Qt
      * resource in :/kxmlgui5/, under a directory named after the component name.
+     *
+     * Since 6.30, the resulting document (merged, if \a merge is set) may come
+     * from an on-disk cache of earlier results. It is then passed to setDOMDocument()
+     * as is, without merging, and setXML() is not called. Results are only cached
+     * for classes of clients whose setXML() doesn't change the XML of the file.
      **/
     virtual void setXMLFile(const QString &file, bool merge = false, bool setXMLDoc = true);
 
@@ -396,6 +443,7 @@ protected:
      *
      * Call this in the Part-inherited class constructor if you
      *  don't call setXMLFile().
+
      **/
     virtual void setXML(const QString &document, bool merge = false);
 
@@ -0,0 +1,55 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kxmlguiconfigfile_p.h"
+
+#include "debug.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QStandardPaths>
+
+KXmlGuiConfigFile::KXmlGuiConfigFile(const QString &filename, const QString &_componentName)
+{
+    QString componentName = _componentName.isEmpty() ? QCoreApplication::applicationName() : _componentName;
+    QString xml_file;
+
+    if (!QDir::isRelativePath(filename)) {
+        xml_file = filename;
+    } else {
+        // first look for any custom user config, admin config or the default deployed as file
+        xml_file = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("kxmlgui5/") + componentName + QLatin1Char('/') + filename);
+        if (!QFile::exists(xml_file)) {
+            // fall-back to any built-in resource file
+            xml_file = QLatin1String(":/kxmlgui5/") + componentName + QLatin1Char('/') + filename;
+        }
+    }
+
+    m_file.setFileName(xml_file);
+    if (xml_file.isEmpty() || !m_file.open(QIODevice::ReadOnly)) {
+        qCCritical(DEBUG_KXMLGUI) << "No such XML file" << filename;
+        return;
+    }
+
+    const qint64 size = m_file.size();
+    if (size <= 0) {
+        return;
+    }
+
+    // The mapping stays valid after closing the file, until m_file is destroyed
+    if (const uchar *mapped = m_file.map(0, size)) {
+        m_data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size);
+    } else {
+        m_data = m_file.readAll();
+    }
+    m_file.close();
+}
+
+QString KXmlGuiConfigFile::toString() const
+{
+    return QString::fromUtf8(m_data);
+}
@@ -0,0 +1,59 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KXMLGUICONFIGFILE_P_H
+#define KXMLGUICONFIGFILE_P_H
+
+#include <QByteArray>
+#include <QFile>
+
+/*!
+ * \internal
+ * \inmodule KXmlGui
+ * \brief Read-only access to the content of an xmlgui (.rc) file.
+ *
+ * The file is memory mapped instead of being read into memory. For
+ * (uncompressed) built-in resources like the :/kxmlgui5/ files, this gives
+ * access to the resource data directly. Only when mapping is not possible
+ * (e.g. for compressed resources) the file is read.
+ *
+ * data() can be passed to QDomDocument::setContent() as it is, saving the
+ * copies made by decoding the file to a QString first.
+ *
+ * KXMLGUIFactory::readConfigFile() is a wrapper around this class.
+ */
+class KXmlGuiConfigFile
+{
+public:
+    /*!
+     * Opens \a filename. Relative file names are looked up for
+     * \a componentName (the application by default), like
+     * KXMLGUIFactory::readConfigFile() does.
+     */
+    explicit KXmlGuiConfigFile(const QString &filename, const QString &componentName = QString());
+
+    /*!
+     * Returns the content of the file (UTF-8), or an empty array on error.
+     *
+     * The returned array doesn't own its data, it must not be used after
+     * this object was destroyed.
+     */
+    QByteArray data() const
+    {
+        return m_data;
+    }
+
+    QString toString() const;
+
+private:
+    Q_DISABLE_COPY(KXmlGuiConfigFile)
+
+    QFile m_file; // owns the mapping
+    QByteArray m_data;
+};
+
+#endif /* KXMLGUICONFIGFILE_P_H */
@@ -0,0 +1,236 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kxmlguidocumentcache_p.h"
+
+#include "debug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimeZone>
+
+#include <kxmlgui_version.h>
+
+// Bump when changing the serialization below
+static const quint32 s_cacheMagic = 0x4b584743; // "KXGC"
+static const quint32 s_cacheFormatVersion = 1;
+
+enum NodeTag : quint8 {
+    EndOfChildren = 0,
+    ElementNode,
+    TextNode,
+    CDATANode,
+    CommentNode,
+    ProcessingInstructionNode,
+};
+
+// Empty if the cache is disabled
+static QString cacheDirectory()
+{
+    // Not cached, so that tests can change it
+    const QString value = qEnvironmentVariable("KXMLGUI_DOCUMENT_CACHE");
+    if (value == QLatin1String("0")) {
+        return QString();
+    }
+    if (!value.isEmpty() && value != QLatin1String("1")) {
+        return value;
+    }
+    // Tests rewrite their .rc files quicker than the mtime resolution
+    if (value.isEmpty() && QStandardPaths::isTestModeEnabled()) {
+        return QString();
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kxmlgui5");
+}
+
+static QString cacheFilePath(const QString &id)
+{
+    const QByteArray hash = QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return cacheDirectory() + QLatin1Char('/') + QLatin1String(hash);
+}
+
+static void writeChildren(QDataStream &stream, const QDomNode &parent)
+{
+    for (QDomNode n = parent.firstChild(); !n.isNull(); n = n.nextSibling()) {
+        switch (n.nodeType()) {
+        case QDomNode::ElementNode: {
+            const QDomElement e = n.toElement();
+            const QDomNamedNodeMap attributes = e.attributes();
+            stream << quint8(ElementNode) << e.tagName() << quint32(attributes.length());
+            for (int i = 0; i < attributes.length(); ++i) {
+                const QDomAttr attr = attributes.item(i).toAttr();
+                stream << attr.name() << attr.value();
+            }
+            writeChildren(stream, e);
+            break;
+        }
+        case QDomNode::TextNode:
+            stream << quint8(TextNode) << n.nodeValue();
+            break;
+        case QDomNode::CDATASectionNode:
+            stream << quint8(CDATANode) << n.nodeValue();
+            break;
+        case QDomNode::CommentNode:
+            stream << quint8(CommentNode) << n.nodeValue();
+            break;
+        case QDomNode::ProcessingInstructionNode: {
+            const QDomProcessingInstruction pi = n.toProcessingInstruction();
+            stream << quint8(ProcessingInstructionNode) << pi.target() << pi.data();
+            break;
+        }
+        default:
+            // Entity references and the like don't appear in xmlgui files
+            break;
+        }
+    }
+    stream << quint8(EndOfChildren);
+}
+
+// parent is a reference so that a null doc can be passed for the top level:
+// it only gets its implementation from the first create*() call.
+static bool readChildren(QDataStream &stream, QDomDocument &doc, QDomNode &parent)
+{
+    while (stream.status() == QDataStream::Ok) {
+        quint8 tag = EndOfChildren;
+        stream >> tag;
+        switch (tag) {
+        case EndOfChildren:
+            return stream.status() == QDataStream::Ok;
+        case ElementNode: {
+            QString tagName;
+            quint32 attributeCount;
+            stream >> tagName >> attributeCount;
+            QDomElement e = doc.createElement(tagName);
+            for (quint32 i = 0; i < attributeCount && stream.status() == QDataStream::Ok; ++i) {
+                QString name;
+                QString value;
+                stream >> name >> value;
+                e.setAttribute(name, value);
+            }
+            parent.appendChild(e);
+            if (!readChildren(stream, doc, e)) {
+                return false;
+            }
+            break;
+        }
+        case TextNode:
+        case CDATANode:
+        case CommentNode: {
+            QString value;
+            stream >> value;
+            if (tag == TextNode) {
+                parent.appendChild(doc.createTextNode(value));
+            } else if (tag == CDATANode) {
+                parent.appendChild(doc.createCDATASection(value));
+            } else {
+                parent.appendChild(doc.createComment(value));
+            }
+            break;
+        }
+        case ProcessingInstructionNode: {
+            QString target;
+            QString data;
+            stream >> target >> data;
+            parent.appendChild(doc.createProcessingInstruction(target, data));
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+bool KXmlGuiDocumentCache::isEnabled()
+{
+    return !cacheDirectory().isEmpty();
+}
+
+QString KXmlGuiDocumentCache::fileFingerprint(const QString &file)
+{
+    const QFileInfo info(file);
+    return QStringLiteral("%1:%2:%3:%4")
+        .arg(file)
+        .arg(info.size())
+        .arg(info.lastModified(QTimeZone::UTC).toMSecsSinceEpoch())
+        .arg(info.metadataChangeTime(QTimeZone::UTC).toMSecsSinceEpoch());
+}
+
+QDomDocument KXmlGuiDocumentCache::load(const QString &id, const QString &key)
+{
+    QFile file(cacheFilePath(id));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QDomDocument();
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic;
+    quint32 formatVersion;
+    QString libraryVersion;
+    QString storedKey;
+    stream >> magic >> formatVersion >> libraryVersion;
+    if (magic != s_cacheMagic || formatVersion != s_cacheFormatVersion || libraryVersion != QLatin1String(KXMLGUI_VERSION_STRING)) {
+        return QDomDocument();
+    }
+    stream >> storedKey;
+    if (storedKey != key) {
+        return QDomDocument();
+    }
+
+    bool hasDocType;
+    stream >> hasDocType;
+    QDomDocument doc;
+    if (hasDocType) {
+        QString name;
+        QString publicId;
+        QString systemId;
+        stream >> name >> publicId >> systemId;
+        doc = QDomDocument(QDomImplementation().createDocumentType(name, publicId, systemId));
+    }
+
+    if (!readChildren(stream, doc, doc) || doc.documentElement().isNull()) {
+        qCWarning(DEBUG_KXMLGUI) << "Ignoring corrupt xmlgui cache file" << file.fileName();
+        return QDomDocument();
+    }
+    return doc;
+}
+
+bool KXmlGuiDocumentCache::save(const QString &id, const QString &key, const QDomDocument &doc)
+{
+    if (doc.documentElement().isNull()) {
+        return false;
+    }
+
+    const QString fileName = cacheFilePath(id);
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(DEBUG_KXMLGUI) << "Could not write xmlgui cache file" << fileName;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << s_cacheMagic << s_cacheFormatVersion << QStringLiteral(KXMLGUI_VERSION_STRING) << key;
+
+    const QDomDocumentType docType = doc.doctype();
+    stream << !docType.isNull();
+    if (!docType.isNull()) {
+        stream << docType.name() << docType.publicId() << docType.systemId();
+    }
+    writeChildren(stream, doc);
+
+    return file.commit();
+}
@@ -0,0 +1,53 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KXMLGUIDOCUMENTCACHE_P_H
+#define KXMLGUIDOCUMENTCACHE_P_H
+
+#include <QStringList>
+
+class QDomDocument;
+
+/*!
+ * \internal
+ * \inmodule KXmlGui
+ * \brief On-disk cache of parsed (and merged) xmlgui documents.
+ *
+ * The documents are stored in a compact binary form under
+ * GenericCacheLocation/kxmlgui5/, so that they can be loaded again without
+ * reading and parsing the .rc files or merging them with ui_standards.rc.
+ *
+ * Every entry is stored under an \a id (one file per id, so the cache does
+ * not grow when the inputs change) together with a \a key describing all
+ * inputs the document was built from. An entry is only used when the key
+ * matches exactly.
+ *
+ * The cache is disabled in test mode. Setting KXMLGUI_DOCUMENT_CACHE=0 or =1
+ * in the environment forces it off or on, setting it to a directory enables
+ * it with that directory instead of the default one.
+ */
+class KXmlGuiDocumentCache
+{
+public:
+    static bool isEnabled();
+
+    /*!
+     * Returns a string identifying the current state of \a file on disk
+     * (path, size and modification times), to be used as part of a key.
+     */
+    static QString fileFingerprint(const QString &file);
+
+    /*!
+     * Returns the document stored for \a id, or a null document if there is
+     * none or if it was built from a different \a key.
+     */
+    static QDomDocument load(const QString &id, const QString &key);
+
+    static bool save(const QString &id, const QString &key, const QDomDocument &doc);
+};
+
+#endif /* KXMLGUIDOCUMENTCACHE_P_H */
@@ -16,14 +16,18 @@
 #include "kshortcutsdialog.h"
 #include "kxmlguibuilder.h"
 #include "kxmlguiclient.h"
+#include "kxmlguiconfigfile_p.h"
 #include "kxmlguifactory_p.h"
 #include "utils_p.h"
 
 #include <QAction>
+#include <QActionGroup>
 #include <QCoreApplication>
 #include <QDir>
 #include <QDomDocument>
 #include <QFile>
+#include <QHash>
+#include <QPointer>
 #include <QStandardPaths>
 #include <QTextStream>
 #include <QVariant>
@@ -35,6 +39,8 @@
 #include <KGlobalAccel>
 #endif
 
+#include <unordered_map>
+
 using namespace KXMLGUI;
 
 class KXMLGUIFactoryPrivate : public BuildState
@@ -52,7 +58,13 @@ public:
     }
     ~KXMLGUIFactoryPrivate()
     {
+        for (const SuspendedClient &suspended : std::as_const(m_suspendedClients)) {
+            forget(suspended);
+        }
         delete m_rootNode;
+        for (const auto &entry : m_containerStates) {
+            QObject::disconnect(entry.second.connection);
+        }
     }
 
     void pushState()
@@ -80,6 +92,32 @@ public:
     void refreshActionProperties(KXMLGUIClient *client, const QList<QAction *> &actions, const QDomDocument &doc);
     void saveDefaultActionProperties(const QList<QAction *> &actions);
 
+    QDomDocument buildDocument(KXMLGUIClient *client) const;
+    void setupClientState(KXMLGUIClient *client, const QDomDocument &doc);
+    ContainerStateHash *savedContainerStates(KXMLGUIClient *client);
+
+    // What suspendClient() hid, to be shown again by resumeClient()
+    struct SuspendedClient {
+        // The actions of the client, hidden by an invisible action group. Qt keeps track of
+        // the actions the application hides meanwhile, and keeps them hidden when showing
+        // the group again.
+        QPointer<QActionGroup> hiddenActions;
+        // The actions which are in an action group already, and the actions of the
+        // containers, made invisible directly
+        QList<QPointer<QAction>> actions;
+        QList<QPointer<QWidget>> containers;
+        // the nodes of the containers hidden as a whole
+        QList<ContainerNode *> nodes;
+        // to notice the application changing the visibility of the actions meanwhile
+        QList<QMetaObject::Connection> connections;
+    };
+    void suspend(ContainerNode *node, KXMLGUIClient *client, SuspendedClient &suspended);
+    void splitSuspendedContainers();
+    static bool isSuspendable(const ContainerNode *node, KXMLGUIClient *client);
+    void hide(QAction *action, KXMLGUIClient *client, SuspendedClient &suspended);
+    static void restore(const SuspendedClient &suspended);
+    static void forget(const SuspendedClient &suspended);
+
     ContainerNode *m_rootNode;
 
     /*
@@ -92,35 +130,33 @@ public:
      */
     QList<KXMLGUIClient *> m_clients;
 
+    /*
+     * The documents the GUI of the clients was built from, used by updateClients()
+     * to find out what changed
+     */
+    QHash<KXMLGUIClient *, QDomDocument> m_builtDocuments;
+
+    QHash<KXMLGUIClient *, SuspendedClient> m_suspendedClients;
+
+    // The container states saved aside by removeClient(), see ContainerStateHash
+    struct SavedContainerStates {
+        // the document of the client the states belong to
+        QDomDocument document;
+        ContainerStateHash states;
+        // to forget about the client once it's deleted
+        QMetaObject::Connection connection;
+    };
+    // node based, pending builds point to the states
+    std::unordered_map<KXMLGUIClient *, SavedContainerStates> m_containerStates;
+
     QString attrName;
 
     BuildStateStack m_stateStack;
 };
 
-QString KXMLGUIFactory::readConfigFile(const QString &filename, const QString &_componentName)
+QString KXMLGUIFactory::readConfigFile(const QString &filename, const QString &componentName)
 {
-    QString componentName = _componentName.isEmpty() ? QCoreApplication::applicationName() : _componentName;
-    QString xml_file;
-
-    if (!QDir::isRelativePath(filename)) {
-        xml_file = filename;
-    } else {
-        // first look for any custom user config, admin config or the default deployed as file
-        xml_file = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("kxmlgui5/") + componentName + QLatin1Char('/') + filename);
-        if (!QFile::exists(xml_file)) {
-            // fall-back to any built-in resource file
-            xml_file = QLatin1String(":/kxmlgui5/") + componentName + QLatin1Char('/') + filename;
-        }
-    }
-
-    QFile file(xml_file);
-    if (xml_file.isEmpty() || !file.open(QIODevice::ReadOnly)) {
-        qCCritical(DEBUG_KXMLGUI) << "No such XML file" << filename;
-        return QString();
-    }
-
-    QByteArray buffer(file.readAll());
-    return QString::fromUtf8(buffer.constData(), buffer.size());
+    return KXmlGuiConfigFile(filename, componentName).toString();
 }
 
 bool KXMLGUIFactory::saveConfigFile(const QDomDocument &doc, const QString &filename, const QString &_componentName)
@@ -202,30 +238,13 @@ void KXMLGUIFactory::addClient(KXMLGUIClient *client)
     //  should be attached to.
     client->beginXMLPlug(d->builder->widget());
 
-    // try to use the build document for building the client's GUI, as the build document
-    // contains the correct container state information (like toolbar positions, sizes, etc.) .
-    // if there is non available, then use the "real" document.
-    QDomDocument doc = client->xmlguiBuildDocument();
-    if (doc.documentElement().isNull()) {
-        doc = client->domDocument();
-    }
-
-    QDomElement docElement = doc.documentElement();
+    const QDomDocument doc = d->buildDocument(client);
+    // not a copy, just another reference to the (implicitly shared) document
+    d->m_builtDocuments.insert(client, doc);
 
     d->m_rootNode->index = -1;
 
-    // cache some variables
-
-    d->clientName = docElement.attribute(d->attrName);
-    d->clientBuilder = client->clientBuilder();
-
-    if (d->clientBuilder) {
-        d->clientBuilderContainerTags = d->clientBuilder->containerTags();
-        d->clientBuilderCustomTags = d->clientBuilder->customTags();
-    } else {
-        d->clientBuilderContainerTags.clear();
-        d->clientBuilderCustomTags.clear();
-    }
+    d->setupClientState(client, doc);
 
     // load shortcut schemes, user-defined shortcuts and other action properties
     d->saveDefaultActionProperties(client->actionCollection()->actions());
@@ -233,7 +252,8 @@ void KXMLGUIFactory::addClient(KXMLGUIClient *client)
         d->refreshActionProperties(client, client->actionCollection()->actions(), doc);
     }
 
-    BuildHelper(*d, d->m_rootNode).build(docElement);
+    BuildHelper(*d, d->m_rootNode).build(doc.documentElement());
+    d->splitSuspendedContainers();
 
     // let the client know that we built its GUI.
     client->setFactory(this);
@@ -274,6 +294,130 @@ void KXMLGUIFactory::addClient(KXMLGUIClient *client)
     //    qCDebug(DEBUG_KXMLGUI) << "addClient took " << dt.elapsed();
 }
 
+QDomDocument KXMLGUIFactoryPrivate::buildDocument(KXMLGUIClient *client) const
+{
+    // try to use the build document for building the client's GUI, as the build document
+    // contains the correct container state information (like toolbar positions, sizes, etc.) .
+    // if there is non available, then use the "real" document.
+    QDomDocument doc = client->xmlguiBuildDocument();
+    if (doc.documentElement().isNull()) {
+        doc = client->domDocument();
+    }
+    return doc;
+}
+
+void KXMLGUIFactoryPrivate::setupClientState(KXMLGUIClient *client, const QDomDocument &doc)
+{
+    // cache some variables
+
+    guiClient = client;
+    clientName = doc.documentElement().attribute(attrName);
+    clientBuilder = client->clientBuilder();
+
+    // restore the state saved aside by removeClient(), unless there is a build document
+    if (client->xmlguiBuildDocument().documentElement().isNull()) {
+        containerStates = savedContainerStates(client);
+    } else {
+        containerStates = nullptr;
+    }
+
+    if (clientBuilder) {
+        clientBuilderContainerTags = clientBuilder->containerTags();
+        clientBuilderCustomTags = clientBuilder->customTags();
+    } else {
+        clientBuilderContainerTags.clear();
+        clientBuilderCustomTags.clear();
+    }
+}
+
+/*
+ * The saved container states of the client, dropped when the client got a new document
+ * (like the build document, which holds them otherwise)
+ */
+ContainerStateHash *KXMLGUIFactoryPrivate::savedContainerStates(KXMLGUIClient *client)
+{
+    SavedContainerStates &saved = m_containerStates[client];
+    const QDomDocument doc = client->domDocument();
+    if (saved.document != doc) {
+        saved.document = doc;
+        saved.states.clear();
+    }
+    if (!saved.connection) {
+        // the action collection is deleted together with the client
+        saved.connection = QObject::connect(client->actionCollection(), &QObject::destroyed, [this, client]() {
+            m_containerStates.erase(client);
+        });
+    }
+    return &saved.states;
+}
+
+void KXMLGUIFactory::updateClients(const QList<KXMLGUIClient *> &clients)
+{
+    // plan the updates of all clients first, so that nothing gets touched
+    // if one of them needs to be rebuilt from scratch
+    QList<UpdateHelper> updates;
+    updates.reserve(clients.size());
+    bool incremental = true;
+    for (KXMLGUIClient *client : clients) {
+        const QDomDocument builtDoc = d->m_builtDocuments.value(client);
+        if (client->factory() != this || builtDoc.isNull() || d->m_suspendedClients.contains(client)) {
+            incremental = false;
+            break;
+        }
+
+        QStringList containerTags = d->builderContainerTags;
+        if (KXMLGUIBuilder *clientBuilder = client->clientBuilder()) {
+            containerTags = clientBuilder->containerTags() + containerTags;
+        }
+
+        // A document changed in place is the document the GUI was built from,
+        // there is nothing to compare it with
+        const QDomDocument doc = d->buildDocument(client);
+        UpdateHelper helper(d->m_rootNode, client, containerTags);
+        if (doc.isNull() || doc == builtDoc || !helper.plan(builtDoc.documentElement(), doc.documentElement())) {
+            incremental = false;
+            break;
+        }
+        updates.append(helper);
+    }
+
+    if (!incremental) {
+        // qCDebug(DEBUG_KXMLGUI) << "can't update incrementally, rebuilding" << clients;
+        for (auto it = clients.crbegin(); it != clients.crend(); ++it) {
+            removeClient(*it);
+        }
+        for (KXMLGUIClient *client : clients) {
+            addClient(client);
+        }
+        return;
+    }
+
+    if (d->emptyState()) {
+        Q_EMIT makingChanges(true);
+    }
+
+    for (qsizetype i = 0; i < clients.size(); ++i) {
+        KXMLGUIClient *client = clients.at(i);
+        d->pushState();
+
+        const QDomDocument doc = d->buildDocument(client);
+        d->setupClientState(client, doc);
+
+        d->saveDefaultActionProperties(client->actionCollection()->actions());
+        d->refreshActionProperties(client, client->actionCollection()->actions(), doc);
+
+        updates[i].apply(*d);
+        d->m_builtDocuments.insert(client, doc);
+
+        d->BuildState::reset();
+        d->popState();
+    }
+
+    if (d->emptyState()) {
+        Q_EMIT makingChanges(false);
+    }
+}
+
 void KXMLGUIFactory::refreshActionProperties()
 {
     for (KXMLGUIClient *client : std::as_const(d->m_clients)) {
@@ -379,6 +523,8 @@ void KXMLGUIFactory::changeShortcutScheme(const QString &scheme)
 void KXMLGUIFactory::forgetClient(KXMLGUIClient *client)
 {
     d->m_clients.erase(std::remove(d->m_clients.begin(), d->m_clients.end(), client), d->m_clients.end());
+    d->m_builtDocuments.remove(client);
+    KXMLGUIFactoryPrivate::forget(d->m_suspendedClients.take(client));
 }
 
 void KXMLGUIFactory::removeClient(KXMLGUIClient *client)
@@ -394,6 +540,15 @@ void KXMLGUIFactory::removeClient(KXMLGUIClient *client)
         Q_EMIT makingChanges(true);
     }
 
+    // don't leave the actions of a suspended client invisible
+    const auto suspendedIt = d->m_suspendedClients.constFind(client);
+    if (suspendedIt != d->m_suspendedClients.cend()) {
+        KXMLGUIFactoryPrivate::restore(*suspendedIt);
+    }
+
+    // the client might have a new document already, see updateClients()
+    const QDomDocument builtDoc = d->m_builtDocuments.value(client);
+
     // remove this client from our client list
     forgetClient(client);
 
@@ -416,14 +571,13 @@ void KXMLGUIFactory::removeClient(KXMLGUIClient *client)
 
     client->setFactory(nullptr);
 
-    // if we don't have a build document for that client, yet, then create one by
-    // cloning the original document, so that saving container information in the
-    // DOM tree does not touch the original document.
-    QDomDocument doc = client->xmlguiBuildDocument();
-    if (doc.documentElement().isNull()) {
-        doc = client->domDocument().cloneNode(true).toDocument();
-        client->setXMLGUIBuildDocument(doc);
+    // if we don't have a build document for that client, then the container information
+    // is saved aside, so that it does not touch the original document. This avoids
+    // copying the whole document for the few containers which have a state to save.
+    if (client->xmlguiBuildDocument().documentElement().isNull()) {
+        d->containerStates = d->savedContainerStates(client);
     }
+    const QDomDocument doc = builtDoc.isNull() ? d->buildDocument(client) : builtDoc;
 
     d->m_rootNode->destruct(doc.documentElement(), *d);
 
@@ -442,6 +596,211 @@ void KXMLGUIFactory::removeClient(KXMLGUIClient *client)
     Q_EMIT clientRemoved(client);
 }
 
+void KXMLGUIFactory::suspendClient(KXMLGUIClient *client)
+{
+    if (!client || client->factory() != this || d->m_suspendedClients.contains(client)) {
+        return;
+    }
+
+    if (d->emptyState()) {
+        Q_EMIT makingChanges(true);
+    }
+
+    const QList<KXMLGUIClient *> childClients(client->childClients());
+    for (KXMLGUIClient *child : childClients) {
+        suspendClient(child);
+    }
+
+    KXMLGUIFactoryPrivate::SuspendedClient &suspended = d->m_suspendedClients[client];
+    suspended.hiddenActions = new QActionGroup(this);
+    suspended.hiddenActions->setExclusionPolicy(QActionGroup::ExclusionPolicy::None);
+    suspended.hiddenActions->setVisible(false);
+    // the actions of the client in lazily populated menus have to be there to be hidden
+    d->m_rootNode->populateClient(*d, client);
+    d->suspend(d->m_rootNode, client, suspended);
+
+    // like removeClient(), so that the shortcuts aren't active anymore
+    client->prepareXMLUnplug(d->builder->widget());
+
+    if (d->emptyState()) {
+        Q_EMIT makingChanges(false);
+    }
+}
+
+void KXMLGUIFactory::resumeClient(KXMLGUIClient *client)
+{
+    if (!client || !d->m_suspendedClients.contains(client)) {
+        return;
+    }
+
+    if (d->emptyState()) {
+        Q_EMIT makingChanges(true);
+    }
+
+    client->beginXMLPlug(d->builder->widget());
+    KXMLGUIFactoryPrivate::restore(d->m_suspendedClients.take(client));
+    client->endXMLPlug();
+
+    const QList<KXMLGUIClient *> childClients(client->childClients());
+    for (KXMLGUIClient *child : childClients) {
+        resumeClient(child);
+    }
+
+    if (d->emptyState()) {
+        Q_EMIT makingChanges(false);
+    }
+}
+
+bool KXMLGUIFactory::isClientSuspended(KXMLGUIClient *client) const
+{
+    return d->m_suspendedClients.contains(client);
+}
+
+/*
+ * Whether the container of the node can be hidden as a whole, i.e. it holds nothing
+ * but the GUI of the client (removeClient() would delete it)
+ */
+bool KXMLGUIFactoryPrivate::isSuspendable(const ContainerNode *node, KXMLGUIClient *client)
+{
+    if (node->client != client) {
+        return false;
+    }
+
+    const bool ownsClients = std::all_of(node->clients.cbegin(), node->clients.cend(), [client](const ContainerClient *containerClient) {
+        return containerClient->client == client;
+    });
+    const bool ownsPendingBuilds = std::all_of(node->pendingBuilds.cbegin(), node->pendingBuilds.cend(), [client](const PendingBuild &build) {
+        return build.client == client;
+    });
+    const bool ownsChildren = std::all_of(node->children.cbegin(), node->children.cend(), [client](const ContainerNode *child) {
+        return isSuspendable(child, client);
+    });
+    return ownsClients && ownsPendingBuilds && ownsChildren;
+}
+
+void KXMLGUIFactoryPrivate::suspend(ContainerNode *node, KXMLGUIClient *client, SuspendedClient &suspended)
+{
+    if (node->container && isSuspendable(node, client)) {
+        if (node->containerAction) {
+            if (node->containerAction->isVisible()) {
+                node->containerAction->setVisible(false);
+                suspended.actions.append(node->containerAction);
+                suspended.nodes.append(node);
+            }
+        } else if (!node->container->isHidden()) {
+            node->container->hide();
+            suspended.containers.append(node->container);
+            suspended.nodes.append(node);
+        }
+        return;
+    }
+
+    auto hideActions = [this, client, &suspended](const QList<QAction *> &actions) {
+        for (QAction *action : actions) {
+            hide(action, client, suspended);
+        }
+    };
+    for (ContainerClient *containerClient : std::as_const(node->clients)) {
+        if (containerClient->client != client) {
+            continue;
+        }
+        hideActions(containerClient->actions);
+        hideActions(containerClient->customElements);
+        for (const ActionList &actionList : std::as_const(containerClient->actionLists)) {
+            hideActions(actionList);
+        }
+    }
+
+    for (ContainerNode *child : std::as_const(node->children)) {
+        suspend(child, client, suspended);
+    }
+}
+
+/*
+ * Shows the containers of suspended clients other clients were built into meanwhile
+ * (e.g. because they use the same container names), and hides just the part of the
+ * suspended client in them instead
+ */
+void KXMLGUIFactoryPrivate::splitSuspendedContainers()
+{
+    for (auto it = m_suspendedClients.begin(); it != m_suspendedClients.end(); ++it) {
+        KXMLGUIClient *client = it.key();
+        SuspendedClient &suspended = it.value();
+        const QList<ContainerNode *> nodes = suspended.nodes;
+        for (ContainerNode *node : nodes) {
+            if (isSuspendable(node, client)) {
+                continue;
+            }
+            suspended.nodes.removeOne(node);
+            if (node->containerAction) {
+                suspended.actions.removeOne(node->containerAction);
+                node->containerAction->setVisible(true);
+            } else {
+                suspended.containers.removeOne(node->container);
+                node->container->show();
+            }
+            suspend(node, client, suspended);
+        }
+    }
+}
+
+void KXMLGUIFactoryPrivate::hide(QAction *action, KXMLGUIClient *client, SuspendedClient &suspended)
+{
+    if (!action->isVisible()) {
+        return;
+    }
+
+    // an action can only be in one group, the application's one is left alone
+    if (!action->actionGroup()) {
+        suspended.hiddenActions->addAction(action);
+        return;
+    }
+
+    action->setVisible(false);
+    suspended.actions.append(action);
+    // don't undo what the application does with the visibility of the action in the meantime,
+    // as far as we can tell
+    suspended.connections.append(QObject::connect(action, &QAction::visibleChanged, suspended.hiddenActions, [this, client, action]() {
+        const auto it = m_suspendedClients.find(client);
+        if (it != m_suspendedClients.end()) {
+            it->actions.removeAll(action);
+        }
+    }));
+}
+
+void KXMLGUIFactoryPrivate::restore(const SuspendedClient &suspended)
+{
+    forget(suspended);
+
+    for (QAction *action : suspended.actions) {
+        if (action) {
+            action->setVisible(true);
+        }
+    }
+    for (QWidget *container : suspended.containers) {
+        if (container) {
+            container->show();
+        }
+    }
+}
+
+void KXMLGUIFactoryPrivate::forget(const SuspendedClient &suspended)
+{
+    for (const QMetaObject::Connection &connection : suspended.connections) {
+        QObject::disconnect(connection);
+    }
+
+    if (QActionGroup *hiddenActions = suspended.hiddenActions) {
+        // shows the actions, except for the ones the application hid meanwhile
+        hiddenActions->setVisible(true);
+        const QList<QAction *> actions = hiddenActions->actions();
+        for (QAction *action : actions) {
+            hiddenActions->removeAction(action);
+        }
+        delete hiddenActions;
+    }
+}
+
 QList<KXMLGUIClient *> KXMLGUIFactory::clients() const
 {
     return d->m_clients;
@@ -454,6 +813,11 @@ QWidget *KXMLGUIFactory::container(const QString &containerName, KXMLGUIClient *
     d->guiClient = client;
 
     QWidget *result = d->findRecursive(d->m_rootNode, useTagName);
+    if (!result) {
+        // it might be in a menu that wasn't populated yet
+        d->m_rootNode->populateAll(*d);
+        result = d->findRecursive(d->m_rootNode, useTagName);
+    }
 
     d->guiClient = nullptr;
     d->m_containerName.clear();
@@ -465,14 +829,30 @@ QWidget *KXMLGUIFactory::container(const QString &containerName, KXMLGUIClient *
 
 QList<QWidget *> KXMLGUIFactory::containers(const QString &tagName)
 {
+    d->m_rootNode->populateAll(*d);
     return d->findRecursive(d->m_rootNode, tagName);
 }
 
+void KXMLGUIFactory::setLazyMenuPopulation(bool lazy)
+{
+    d->lazyMenus = lazy;
+}
+
+bool KXMLGUIFactory::lazyMenuPopulation() const
+{
+    return d->lazyMenus;
+}
+
 void KXMLGUIFactory::reset()
 {
     d->m_rootNode->reset();
 
     d->m_rootNode->clearChildren();
+    d->m_builtDocuments.clear();
+    for (const KXMLGUIFactoryPrivate::SuspendedClient &suspended : std::as_const(d->m_suspendedClients)) {
+        KXMLGUIFactoryPrivate::forget(suspended);
+    }
+    d->m_suspendedClients.clear();
 }
 
 void KXMLGUIFactory::resetContainer(const QString &containerName, bool useTagName)
@@ -483,6 +863,17 @@ void KXMLGUIFactory::resetContainer(const QString &containerName, bool useTagNam
 
     ContainerNode *container = d->m_rootNode->findContainer(containerName, useTagName);
     if (container && container->parent) {
+        // forget about the hidden containers of suspended clients going away
+        for (KXMLGUIFactoryPrivate::SuspendedClient &suspended : d->m_suspendedClients) {
+            suspended.nodes.removeIf([container](const ContainerNode *node) {
+                for (; node; node = node->parent) {
+                    if (node == container) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+        }
         container->parent->removeChild(container);
     }
 }
@@ -527,6 +918,7 @@ void KXMLGUIFactory::plugActionList(KXMLGUIClient *client, const QString &name,
     d->actionList = actionList;
     d->clientName = client->domDocument().documentElement().attribute(d->attrName);
 
+    d->m_rootNode->populateActionList(*d);
     d->m_rootNode->plugActionList(*d);
 
     // Load shortcuts for these new actions
@@ -544,6 +936,7 @@ void KXMLGUIFactory::unplugActionList(KXMLGUIClient *client, const QString &name
     d->actionListName = name;
     d->clientName = client->domDocument().documentElement().attribute(d->attrName);
 
+    d->m_rootNode->populateActionList(*d);
     d->m_rootNode->unplugActionList(*d);
 
     d->BuildState::reset();
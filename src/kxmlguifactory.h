@@ -112,6 +112,65 @@ public:
      */
     void removeClient(KXMLGUIClient *client);
 
+    /*!
+     * \brief Updates the GUI of the already added \a clients after their
+     * documents changed, e.g. after calling KXMLGUIClient::setXMLFile() again.
+     *
+     * Only the containers whose content changed are rebuilt, all other
+     * containers (and their widgets) are left untouched. When that is not
+     * possible, for instance because containers were added, removed or
+     * renamed, or because other clients merged into a changed container,
+     * all \a clients are removed (in reverse order) and added again, just like
+     * with removeClient() and addClient(). This is also the case for a client
+     * whose KXMLGUIClient::domDocument() was changed in place, as there is no
+     * older document to compare it with.
+     *
+     * \since 6.30
+     */
+    void updateClients(const QList<KXMLGUIClient *> &clients);
+
+    /*!
+     * \brief Hides the GUI of the \a client (and of its child clients) without
+     * removing it.
+     *
+     * The containers owned by the client are hidden and the client's actions
+     * in the other containers are made invisible, which also disables their
+     * shortcuts. Everything else (the containers, the plugged actions and the
+     * merging information) is kept, so that resumeClient() can show the GUI
+     * again without rebuilding it. This is much cheaper than removeClient() and
+     * addClient() when switching between clients (e.g. parts) repeatedly.
+     *
+     * Actions made invisible here are made visible again by resumeClient(),
+     * unless the application hides them in the meantime. To keep track of that,
+     * the actions which aren't in a QActionGroup already are put into an
+     * invisible one until then.
+     *
+     * Clients added in the meantime are shown, even where they share
+     * containers with the suspended client.
+     *
+     * Removing or updating a suspended client resumes it.
+     *
+     * \sa resumeClient(), isClientSuspended()
+     * \since 6.30
+     */
+    void suspendClient(KXMLGUIClient *client);
+
+    /*!
+     * \brief Shows the GUI of the \a client (and of its child clients) hidden
+     * by suspendClient() again.
+     *
+     * \sa suspendClient()
+     * \since 6.30
+     */
+    void resumeClient(KXMLGUIClient *client);
+
+    /*!
+     * \brief Returns whether the GUI of the \a client is hidden by suspendClient().
+     *
+     * \since 6.30
+     */
+    bool isClientSuspended(KXMLGUIClient *client) const;
+
     void plugActionList(KXMLGUIClient *client, const QString &name, const QList<QAction *> &actionList);
     void unplugActionList(KXMLGUIClient *client, const QString &name);
 
@@ -184,6 +243,34 @@ public:
      */
     void resetContainer(const QString &containerName, bool useTagName = false);
 
+    /*!
+     * \brief Enables or disables the lazy population of menus.
+     *
+     * When enabled, menus are created empty and their actions, separators and
+     * submenus are only added right before they are shown for the first time
+     * (on QMenu::aboutToShow()). This makes adding clients with many (nested)
+     * menus a lot cheaper. Shortcuts of the actions keep working in the meantime,
+     * as they don't depend on the menus.
+     *
+     * The menus are populated on demand as well when an action list is plugged
+     * into them, or when they are looked up with container() or containers().
+     * Code accessing QMenu::actions() of an XMLGUI menu directly has to emit
+     * QMenu::aboutToShow() first.
+     *
+     * This only affects clients added afterwards. The default is \c false.
+     *
+     * \since 6.30
+     */
+    void setLazyMenuPopulation(bool lazy);
+
+    /*!
+     * \brief Returns whether menus are populated lazily.
+     *
+     * \sa setLazyMenuPopulation()
+     * \since 6.30
+     */
+    bool lazyMenuPopulation() const;
+
     /*!
      * \brief Use this method to reset and reread action properties
      * (shortcuts, etc.) for all actions.
@@ -12,7 +12,10 @@
 #include "kxmlguiclient.h"
 #include "utils_p.h"
 
+#include <QLayout>
 #include <QList>
+#include <QMenu>
+#include <QSet>
 #include <QWidget>
 
 #include "debug.h"
@@ -21,20 +24,109 @@
 
 using namespace KXMLGUI;
 
+static bool sameAttributes(const QDomElement &lhs, const QDomElement &rhs)
+{
+    const QDomNamedNodeMap lhsAttributes = lhs.attributes();
+    if (lhsAttributes.count() != rhs.attributes().count()) {
+        return false;
+    }
+
+    for (int i = 0; i < lhsAttributes.count(); ++i) {
+        const QDomAttr attribute = lhsAttributes.item(i).toAttr();
+        if (!rhs.hasAttribute(attribute.name()) || rhs.attribute(attribute.name()) != attribute.value()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void ActionList::plug(QWidget *container, int index) const
 {
+    if (isEmpty()) {
+        return;
+    }
+
     QAction *before = nullptr; // Insert after end of widget's current actions (default).
 
-    if ((index < 0) || (index > container->actions().count())) {
-        qCWarning(DEBUG_KXMLGUI) << "Index " << index << " is not within range (0 - " << container->actions().count() << ")";
-    } else if (index != container->actions().count()) {
-        before = container->actions().at(index); // Insert before indexed action.
+    const QList<QAction *> containerActions = container->actions();
+    if ((index < 0) || (index > containerActions.count())) {
+        qCWarning(DEBUG_KXMLGUI) << "Index " << index << " is not within range (0 - " << containerActions.count() << ")";
+    } else if (index != containerActions.count()) {
+        before = containerActions.at(index); // Insert before indexed action.
+    }
+
+    // Action lists can be long (recent files, bookmarks...), so don't let e.g. a toolbar
+    // relayout and repaint itself for every single action
+    const bool updatesEnabled = container->updatesEnabled();
+    container->setUpdatesEnabled(false);
+    QLayout *layout = container->layout();
+    const bool layoutEnabled = layout && layout->isEnabled();
+    if (layoutEnabled) {
+        layout->setEnabled(false);
+    }
+
+    // all before the same action, so that they keep their order
+    container->insertActions(before, *this);
+
+    if (layoutEnabled) {
+        layout->setEnabled(true);
+        layout->invalidate();
+    }
+    container->setUpdatesEnabled(updatesEnabled);
+}
+
+MergingIndexList::iterator MergingIndexList::findIndex(const QString &mergingName)
+{
+    if (!m_positionsValid) {
+        updatePositions();
+    }
+
+    const auto it = m_positions.constFind(mergingName);
+    return it != m_positions.cend() ? m_indices.begin() + *it : m_indices.end();
+}
+
+void MergingIndexList::insertIndex(const_iterator before, const MergingIndex &index)
+{
+    const qsizetype position = before - m_indices.cbegin();
+    m_indices.insert(position, index);
+    if (!m_positionsValid) {
+        return;
+    }
+
+    // only the indices after the new one moved, usually there are none as indices get appended.
+    // Backwards, so that a moved position isn't mistaken for the one of a later index.
+    for (qsizetype i = m_indices.size() - 1; i > position; --i) {
+        const auto it = m_positions.find(m_indices.at(i).mergingName);
+        if (it != m_positions.end() && *it == i - 1) {
+            *it = i;
+        }
+    }
+    const auto it = m_positions.find(index.mergingName);
+    if (it == m_positions.end() || *it >= position) {
+        m_positions.insert(index.mergingName, position);
+    }
+}
+
+void MergingIndexList::removeClientIndices(const QString &clientName)
+{
+    const qsizetype removed = m_indices.removeIf([&clientName](const MergingIndex &index) {
+        return index.clientName == clientName;
+    });
+    if (removed) {
+        m_positionsValid = false;
     }
+}
 
-    for (QAction *action : *this) {
-        container->insertAction(before, action);
-        // before = action; // BUG FIX: do not insert actions in reverse order.
+void MergingIndexList::updatePositions()
+{
+    m_positions.clear();
+    m_positions.reserve(m_indices.size());
+    // backwards, so that the first one wins like with a linear search
+    for (qsizetype i = m_indices.size() - 1; i >= 0; --i) {
+        m_positions.insert(m_indices.at(i).mergingName, i);
     }
+    m_positionsValid = true;
 }
 
 ContainerNode::ContainerNode(QWidget *_container,
@@ -63,11 +155,13 @@ ContainerNode::ContainerNode(QWidget *_container,
 {
     if (parent) {
         parent->children.append(this);
+        parent->indexChild(this);
     }
 }
 
 ContainerNode::~ContainerNode()
 {
+    QObject::disconnect(populateConnection);
     qDeleteAll(children);
     qDeleteAll(clients);
 }
@@ -80,20 +174,44 @@ void ContainerNode::removeChild(ContainerNode *child)
 
 void ContainerNode::deleteChild(ContainerNode *child)
 {
+    unindexChild(child);
     MergingIndexList::iterator mergingIt = findIndex(child->mergingName);
     adjustMergingIndices(-1, mergingIt, QString());
     delete child;
 }
 
+void ContainerNode::indexChild(ContainerNode *child)
+{
+    if (!child->name.isEmpty()) {
+        childrenByName[child->name].append(child);
+    }
+    childrenByTagName[child->tagName.toLower()].append(child);
+}
+
+void ContainerNode::unindexChild(ContainerNode *child)
+{
+    const auto unindex = [child](QHash<QString, QList<ContainerNode *>> &index, const QString &key) {
+        const auto it = index.find(key);
+        if (it != index.end()) {
+            it->removeOne(child);
+            if (it->isEmpty()) {
+                index.erase(it);
+            }
+        }
+    };
+    if (!child->name.isEmpty()) {
+        unindex(childrenByName, child->name);
+    }
+    unindex(childrenByTagName, child->tagName.toLower());
+}
+
 /*
  * Find a merging index with the given name. Used to find an index defined by <Merge name="blah"/>
  * or by a <DefineGroup name="foo" /> tag.
  */
 MergingIndexList::iterator ContainerNode::findIndex(const QString &name)
 {
-    return std::find_if(mergingIndices.begin(), mergingIndices.end(), [&name](const MergingIndex &idx) {
-        return idx.mergingName == name;
-    });
+    return mergingIndices.findIndex(name);
 }
 
 /*
@@ -124,11 +242,19 @@ ContainerNode *ContainerNode::findContainer(const QString &_name, bool tag)
  */
 ContainerNode *ContainerNode::findContainer(const QString &name, const QString &tagName, const QList<QWidget *> *excludeList, KXMLGUIClient * /*currClient*/)
 {
-    if (!name.isEmpty()) {
-        auto it = std::find_if(children.cbegin(), children.cend(), [&name, excludeList](ContainerNode *node) {
-            return node->name == name && !excludeList->contains(node->container);
+    const auto findFirst = [excludeList](const QHash<QString, QList<ContainerNode *>> &index, const QString &key) -> ContainerNode * {
+        const auto candidates = index.constFind(key);
+        if (candidates == index.cend()) {
+            return nullptr;
+        }
+        auto it = std::find_if(candidates->cbegin(), candidates->cend(), [excludeList](ContainerNode *node) {
+            return !excludeList->contains(node->container);
         });
-        return it != children.cend() ? *it : nullptr;
+        return it != candidates->cend() ? *it : nullptr;
+    };
+
+    if (!name.isEmpty()) {
+        return findFirst(childrenByName, name);
     }
 
     if (!tagName.isEmpty()) {
@@ -143,10 +269,7 @@ ContainerNode *ContainerNode::findContainer(const QString &name, const QString &
         // <MenuBar>
         //   <Menu>
         //    ...
-        auto it = std::find_if(children.cbegin(), children.cend(), [&tagName, excludeList](ContainerNode *node) {
-            return equals(node->tagName, tagName) && !excludeList->contains(node->container);
-        });
-        return it != children.cend() ? *it : nullptr;
+        return findFirst(childrenByTagName, tagName.toLower());
     };
 
     return {};
@@ -155,11 +278,9 @@ ContainerNode *ContainerNode::findContainer(const QString &name, const QString &
 ContainerClient *
 ContainerNode::findChildContainerClient(KXMLGUIClient *currentGUIClient, const QString &groupName, const MergingIndexList::iterator &mergingIdx)
 {
-    auto it = std::find_if(clients.cbegin(), clients.cend(), [&groupName, currentGUIClient](ContainerClient *cl) {
-        return cl->client == currentGUIClient && (groupName.isEmpty() || groupName == cl->groupName);
-    });
-    if (it != clients.cend()) {
-        return *it;
+    const std::pair key(currentGUIClient, groupName);
+    if (ContainerClient *client = clientIndex.value(key)) {
+        return client;
     }
 
     ContainerClient *client = new ContainerClient;
@@ -171,6 +292,11 @@ ContainerNode::findChildContainerClient(KXMLGUIClient *currentGUIClient, const Q
     }
 
     clients.append(client);
+    clientIndex.insert(key, client);
+    const std::pair firstKey(currentGUIClient, QString());
+    if (!clientIndex.contains(firstKey)) {
+        clientIndex.insert(firstKey, client);
+    }
 
     return client;
 }
@@ -283,22 +409,35 @@ bool ContainerNode::destruct(
     unplugActions(state);
 
     // remove all merging indices the client defined
-    QMutableListIterator<MergingIndex> cmIt = mergingIndices;
-    while (cmIt.hasNext()) {
-        if (cmIt.next().clientName == state.clientName) {
-            cmIt.remove();
-        }
-    }
+    mergingIndices.removeClientIndices(state.clientName);
+
+    // forget about the parts of the client that were never built
+    pendingBuilds.removeIf([&state](const PendingBuild &build) {
+        return build.client == state.guiClient;
+    });
 
     // ### check for merging index count, too?
-    if (clients.isEmpty() && children.isEmpty() && container && client == state.guiClient) {
+    if (clients.isEmpty() && children.isEmpty() && pendingBuilds.isEmpty() && container && client == state.guiClient) {
         QWidget *parentContainer = nullptr;
         if (parent && parent->container) {
             parentContainer = parent->container;
         }
 
         Q_ASSERT(builder);
-        builder->removeContainer(container, parentContainer, element, containerAction);
+        if (state.containerStates && !element.isNull()) {
+            // leave the document alone, the builder only stores attributes anyway
+            QDomElement stateElement = element.cloneNode(false).toElement();
+            builder->removeContainer(container, parentContainer, stateElement, containerAction);
+
+            const QString path = parent->statePath(tagName, name);
+            if (sameAttributes(stateElement, element)) {
+                state.containerStates->remove(path);
+            } else {
+                state.containerStates->insert(path, stateElement);
+            }
+        } else {
+            builder->removeContainer(container, parentContainer, element, containerAction);
+        }
 
         client = nullptr;
         return true;
@@ -313,11 +452,17 @@ bool ContainerNode::destruct(
 
 void ContainerNode::destructChildren(const QDomElement &element, BuildState &state)
 {
+    if (children.isEmpty()) {
+        return;
+    }
+
+    const QHash<std::pair<QString, QString>, QDomElement> elements = childElements(element);
+
     QMutableListIterator<ContainerNode *> childIt = children;
     while (childIt.hasNext()) {
         ContainerNode *childNode = childIt.next();
 
-        QDomElement childElement = findElementForChild(element, childNode);
+        QDomElement childElement = elements.value({childNode->tagName.toLower(), childNode->name});
 
         // destruct returns true in case the container really got deleted
         if (childNode->destruct(childElement, state)) {
@@ -327,18 +472,28 @@ void ContainerNode::destructChildren(const QDomElement &element, BuildState &sta
     }
 }
 
-QDomElement ContainerNode::findElementForChild(const QDomElement &baseElement, ContainerNode *childNode)
+/*
+ * The child elements of baseElement by (lowercased) tag name and name attribute, to find
+ * the elements of the child containers.
+ */
+QHash<std::pair<QString, QString>, QDomElement> ContainerNode::childElements(const QDomElement &baseElement)
 {
-    // ### slow
-    for (QDomNode n = baseElement.firstChild(); !n.isNull(); n = n.nextSibling()) {
-        QDomElement e = n.toElement();
-        if (equals(e.tagName(), childNode->tagName) //
-            && e.attribute(QStringLiteral("name")) == childNode->name) {
-            return e;
-        }
+    QHash<std::pair<QString, QString>, QDomElement> elements;
+    // backwards, so that the first one wins like with a linear search
+    for (QDomElement e = baseElement.lastChildElement(); !e.isNull(); e = e.previousSiblingElement()) {
+        elements.insert({e.tagName().toLower(), e.attribute(QStringLiteral("name"))}, e);
     }
+    return elements;
+}
 
-    return QDomElement();
+/*
+ * Identifies a child container (to be) created for this node, across removing and
+ * adding the client again, see ContainerStateHash
+ */
+QString ContainerNode::statePath(const QString &childTagName, const QString &childName) const
+{
+    const QString path = parent ? parent->statePath(tagName, name) : QString();
+    return path + QLatin1Char('/') + childTagName.toLower() + QLatin1Char(':') + childName;
 }
 
 void ContainerNode::unplugActions(BuildState &state)
@@ -355,6 +510,8 @@ void ContainerNode::unplugActions(BuildState &state)
         if ((*it)->client == state.guiClient) {
             auto container = *it;
             it = clients.erase(it);
+            clientIndex.remove({container->client, container->groupName});
+            clientIndex.remove({container->client, QString()});
             toRemove.push_back(container);
         } else {
             ++it;
@@ -362,45 +519,87 @@ void ContainerNode::unplugActions(BuildState &state)
     }
 
     // Do the actual remove
-    for (auto *c : toRemove) {
-        unplugClient(c);
-        delete c;
+    if (!toRemove.isEmpty()) {
+        unplugClients(toRemove);
+        qDeleteAll(toRemove);
     }
 }
 
+/*
+ * Removes the actions from the container in a single pass over the container's actions,
+ * adjusting the merging indices once at the end.
+ */
 void ContainerNode::removeActions(const QList<QAction *> &actions)
 {
-    for (QAction *action : actions) {
-        const int pos = container->actions().indexOf(action);
-        if (pos != -1) {
-            container->removeAction(action);
-            for (MergingIndex &idx : mergingIndices) {
-                if (idx.value > pos) {
-                    --idx.value;
-                }
-            }
-            --index;
+    if (actions.isEmpty()) {
+        return;
+    }
+
+    const QSet<QAction *> toRemove(actions.cbegin(), actions.cend());
+    const QList<QAction *> containerActions = container->actions();
+
+    // the positions of the removed actions, ascending
+    QList<int> positions;
+    for (int pos = 0; pos < containerActions.size(); ++pos) {
+        if (toRemove.contains(containerActions.at(pos))) {
+            positions.append(pos);
         }
     }
+
+    for (int pos : std::as_const(positions)) {
+        container->removeAction(containerActions.at(pos));
+    }
+
+    // every merging index moves by the number of actions removed before it
+    for (MergingIndex &idx : mergingIndices) {
+        idx.value -= int(std::lower_bound(positions.cbegin(), positions.cend(), idx.value) - positions.cbegin());
+    }
+    index -= int(positions.size());
 }
 
-void ContainerNode::unplugClient(ContainerClient *client)
+/*
+ * Unplugs everything of the given clients at once, without repainting or relayouting
+ * the container for every single action.
+ */
+void ContainerNode::unplugClients(const ContainerClientList &containerClients)
 {
     assert(builder);
 
     KToolBar *bar = qobject_cast<KToolBar *>(container);
-    if (bar) {
-        bar->removeXMLGUIClient(client->client);
+
+    QList<QAction *> actions;
+    for (ContainerClient *containerClient : containerClients) {
+        if (bar) {
+            bar->removeXMLGUIClient(containerClient->client);
+        }
+
+        // custom elements (i.e. separators), actions and action lists
+        actions += containerClient->customElements;
+        actions += containerClient->actions;
+        for (const auto &actionList : std::as_const(containerClient->actionLists)) {
+            actions += actionList;
+        }
     }
 
-    // now quickly remove all custom elements (i.e. separators) and unplug all actions
-    removeActions(client->customElements);
-    removeActions(client->actions);
+    const bool visible = container->isVisible();
+    const bool updatesEnabled = container->updatesEnabled();
+    QLayout *layout = container->layout();
+    const bool layoutEnabled = layout && layout->isEnabled();
+    if (visible) {
+        container->setUpdatesEnabled(false);
+    }
+    if (layoutEnabled) {
+        layout->setEnabled(false);
+    }
 
-    // unplug all actionslists
+    removeActions(actions);
 
-    for (const auto &actionList : std::as_const(client->actionLists)) {
-        removeActions(actionList);
+    if (layoutEnabled) {
+        layout->setEnabled(true);
+        layout->invalidate();
+    }
+    if (visible) {
+        container->setUpdatesEnabled(updatesEnabled);
     }
 }
 
@@ -413,6 +612,117 @@ void ContainerNode::reset()
     if (client) {
         client->setFactory(nullptr);
     }
+
+    for (const PendingBuild &build : std::as_const(pendingBuilds)) {
+        build.client->setFactory(nullptr);
+    }
+}
+
+void ContainerNode::deferBuild(const QDomElement &element, BuildState &state)
+{
+    pendingBuilds.append({state.guiClient,
+                          state.clientName,
+                          state.clientBuilder,
+                          state.clientBuilderCustomTags,
+                          state.clientBuilderContainerTags,
+                          state.containerStates,
+                          element});
+
+    if (!populateConnection) {
+        QMenu *menu = qobject_cast<QMenu *>(container);
+        Q_ASSERT(menu);
+        // state is the factory's, which outlives the node
+        populateConnection = QObject::connect(menu, &QMenu::aboutToShow, menu, [this, &state]() {
+            populate(state);
+        });
+    }
+}
+
+/*
+ * Builds what was deferred for this node, in the same order it would have been built
+ * when the clients were added, so that merging gives the same result.
+ */
+void ContainerNode::populate(BuildState &state)
+{
+    if (pendingBuilds.isEmpty()) {
+        return;
+    }
+
+    QObject::disconnect(populateConnection);
+    populateConnection = {};
+
+    const QList<PendingBuild> builds = std::exchange(pendingBuilds, {});
+    const BuildState oldState = state;
+
+    for (const PendingBuild &build : builds) {
+        state.guiClient = build.client;
+        state.clientName = build.clientName;
+        state.clientBuilder = build.clientBuilder;
+        state.clientBuilderCustomTags = build.clientBuilderCustomTags;
+        state.clientBuilderContainerTags = build.clientBuilderContainerTags;
+        state.containerStates = build.containerStates;
+        state.actionListName.clear();
+        state.actionList.clear();
+
+        BuildHelper(state, this).build(build.element);
+    }
+
+    state = oldState;
+}
+
+void ContainerNode::populateAll(BuildState &state)
+{
+    populate(state);
+
+    for (ContainerNode *child : std::as_const(children)) {
+        child->populateAll(state);
+    }
+}
+
+/*
+ * Populates the lazily built menus holding some of the GUI of the client, leaving
+ * the menus of the other clients alone.
+ */
+void ContainerNode::populateClient(BuildState &state, KXMLGUIClient *client)
+{
+    const bool hasClient = std::any_of(pendingBuilds.cbegin(), pendingBuilds.cend(), [client](const PendingBuild &build) {
+        return build.client == client;
+    });
+    if (hasClient) {
+        populate(state);
+    }
+
+    for (ContainerNode *child : std::as_const(children)) {
+        child->populateClient(state, client);
+    }
+}
+
+static bool containsActionList(const QDomElement &element, const QString &actionListName)
+{
+    for (QDomElement e = element.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
+        if (equals(e.tagName(), "actionlist") ? e.attribute(QStringLiteral("name")) == actionListName : containsActionList(e, actionListName)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Populates the lazily built menus that contain the action list state.actionListName,
+ * so that it can be plugged into (or unplugged from) them.
+ */
+void ContainerNode::populateActionList(BuildState &state)
+{
+    const bool hasActionList = std::any_of(pendingBuilds.cbegin(), pendingBuilds.cend(), [&state](const PendingBuild &build) {
+        return containsActionList(build.element, state.actionListName);
+    });
+    if (hasActionList) {
+        populate(state);
+    }
+
+    for (ContainerNode *child : std::as_const(children)) {
+        child->populateActionList(state);
+    }
 }
 
 int ContainerNode::calcMergingIndex(const QString &mergingName, MergingIndexList::iterator &it, BuildState &state, bool ignoreDefaultMergingIndex)
@@ -438,7 +748,7 @@ void ContainerNode::dump(int offset)
 {
     QString indent;
     indent.fill(QLatin1Char(' '), offset);
-    qCDebug(DEBUG_KXMLGUI) << qPrintable(indent) << name << tagName << groupName << mergingName << mergingIndices;
+    qCDebug(DEBUG_KXMLGUI) << qPrintable(indent) << name << tagName << groupName << mergingName << mergingIndices.indices();
     for (ContainerNode *child : std::as_const(children)) {
         child->dump(offset + 2);
     }
@@ -471,24 +781,62 @@ int BuildHelper::calcMergingIndex(const QDomElement &element, MergingIndexList::
     return idx;
 }
 
+static TagKindHash createTagKinds(const QStringList &customTags, const QStringList &containerTags)
+{
+    TagKindHash tagKinds;
+
+    // tags are matched case-insensitively, store the usual spelling and the lower case one,
+    // and insert by increasing priority, so that e.g. a custom tag wins over a container tag
+    const auto insert = [&tagKinds](const QString &tag, TagKind kind) {
+        tagKinds.insert(tag, kind);
+        tagKinds.insert(tag.toLower(), kind);
+    };
+
+    insert(QStringLiteral("State"), TagKind::State);
+    insert(QStringLiteral("Merge"), TagKind::Merge);
+    insert(QStringLiteral("DefineGroup"), TagKind::Merge);
+    insert(QStringLiteral("ActionList"), TagKind::Merge);
+    for (const QString &tag : containerTags) {
+        insert(tag, TagKind::Container);
+    }
+    for (const QString &tag : customTags) {
+        insert(tag, TagKind::Custom);
+    }
+    insert(QStringLiteral("Action"), TagKind::Action);
+
+    return tagKinds;
+}
+
 BuildHelper::BuildHelper(BuildState &state, ContainerNode *node)
     : containerClient(nullptr)
     , ignoreDefaultMergingIndex(false)
     , m_state(state)
     , parentNode(node)
 {
-    // create a list of supported container and custom tags
-    customTags = m_state.builderCustomTags;
-    containerTags = m_state.builderContainerTags;
-
     if (parentNode->builder != m_state.builder) {
-        customTags += parentNode->builderCustomTags;
-        containerTags += parentNode->builderContainerTags;
-    }
+        // create a list of supported container and custom tags
+        QStringList customTags = m_state.builderCustomTags + parentNode->builderCustomTags;
+        QStringList containerTags = m_state.builderContainerTags + parentNode->builderContainerTags;
 
-    if (m_state.clientBuilder) {
-        customTags = m_state.clientBuilderCustomTags + customTags;
-        containerTags = m_state.clientBuilderContainerTags + containerTags;
+        if (m_state.clientBuilder) {
+            customTags = m_state.clientBuilderCustomTags + customTags;
+            containerTags = m_state.clientBuilderContainerTags + containerTags;
+        }
+
+        localTagKinds = createTagKinds(customTags, containerTags);
+        tagKinds = &localTagKinds;
+    } else {
+        // the common case, only depends on the builders of the state, so don't redo this for every container
+        if (m_state.tagKinds.isEmpty() || m_state.tagKindsClientBuilder != m_state.clientBuilder) {
+            if (m_state.clientBuilder) {
+                m_state.tagKinds = createTagKinds(m_state.clientBuilderCustomTags + m_state.builderCustomTags,
+                                                  m_state.clientBuilderContainerTags + m_state.builderContainerTags);
+            } else {
+                m_state.tagKinds = createTagKinds(m_state.builderCustomTags, m_state.builderContainerTags);
+            }
+            m_state.tagKindsClientBuilder = m_state.clientBuilder;
+        }
+        tagKinds = &m_state.tagKinds;
     }
 
     m_state.currentDefaultMergingIt = parentNode->findIndex(QStringLiteral("<default>"));
@@ -506,21 +854,41 @@ void BuildHelper::build(const QDomElement &element)
     }
 }
 
+TagKind BuildHelper::tagKind(const QString &tag)
+{
+    const auto it = tagKinds->constFind(tag);
+    if (it != tagKinds->cend()) {
+        return *it;
+    }
+
+    // unusual spelling or unknown tag (like <text>), remember it for the next time
+    const TagKind kind = tagKinds->value(tag.toLower(), TagKind::Other);
+    tagKinds->insert(tag, kind);
+    return kind;
+}
+
 void BuildHelper::processElement(const QDomElement &e)
 {
     const QString tag = e.tagName();
-    QString currName(e.attribute(QStringLiteral("name")));
 
-    const bool isActionTag = equals(tag, "action");
-
-    if (isActionTag || customTags.indexOf(tag, 0, Qt::CaseInsensitive) != -1) {
-        processActionOrCustomElement(e, isActionTag);
-    } else if (containerTags.indexOf(tag, 0, Qt::CaseInsensitive) != -1) {
-        processContainerElement(e, tag, currName);
-    } else if (equals(tag, "merge") || equals(tag, "definegroup") || equals(tag, "actionlist")) {
-        processMergeElement(tag, currName, e);
-    } else if (equals(tag, "state")) {
+    switch (tagKind(tag)) {
+    case TagKind::Action:
+        processActionOrCustomElement(e, true);
+        break;
+    case TagKind::Custom:
+        processActionOrCustomElement(e, false);
+        break;
+    case TagKind::Container:
+        processContainerElement(e, tag, e.attribute(QStringLiteral("name")));
+        break;
+    case TagKind::Merge:
+        processMergeElement(tag, e.attribute(QStringLiteral("name")), e);
+        break;
+    case TagKind::State:
         processStateElement(e);
+        break;
+    case TagKind::Other:
+        break;
     }
 }
 
@@ -688,9 +1056,9 @@ void BuildHelper::processMergeElement(const QString &tag, const QString &name, c
 
     // if that merging index is "inside" another one, then append it right after the "parent".
     if (mIt != parentNode->mergingIndices.end()) {
-        parentNode->mergingIndices.insert(++mIt, newIdx);
+        parentNode->mergingIndices.insertIndex(++mIt, newIdx);
     } else {
-        parentNode->mergingIndices.append(newIdx);
+        parentNode->mergingIndices.insertIndex(parentNode->mergingIndices.cend(), newIdx);
     }
 
     if (mergingName == defaultMergingName) {
@@ -706,6 +1074,7 @@ void BuildHelper::processMergeElement(const QString &tag, const QString &name, c
 void BuildHelper::processContainerElement(const QDomElement &e, const QString &tag, const QString &name)
 {
     ContainerNode *containerNode = parentNode->findContainer(name, tag, &containerList, m_state.guiClient);
+    bool lazy = false;
 
     if (!containerNode) {
         MergingIndexList::iterator it(m_state.currentClientMergingIt);
@@ -717,7 +1086,19 @@ void BuildHelper::processContainerElement(const QDomElement &e, const QString &t
 
         KXMLGUIBuilder *builder;
 
-        QWidget *container = createContainer(parentNode->container, idx, e, containerAction, &builder);
+        QDomElement element = e;
+        if (m_state.containerStates) {
+            const auto stateIt = m_state.containerStates->constFind(parentNode->statePath(tag, name));
+            if (stateIt != m_state.containerStates->cend()) {
+                // restore the state saved when the client was removed, on a copy of the element
+                element = stateIt->cloneNode(false).toElement();
+                for (QDomNode n = e.firstChild(); !n.isNull(); n = n.nextSibling()) {
+                    element.appendChild(n.cloneNode(true));
+                }
+            }
+        }
+
+        QWidget *container = createContainer(parentNode->container, idx, element, containerAction, &builder);
 
         // no container? (probably some <text> tag or so ;-)
         if (!container) {
@@ -750,6 +1131,7 @@ void BuildHelper::processContainerElement(const QDomElement &e, const QString &t
 
         containerNode =
             new ContainerNode(container, tag.toLower(), name, parentNode, m_state.guiClient, builder, containerAction, mergingName, group, cusTags, conTags);
+        lazy = m_state.lazyMenus && qobject_cast<QMenu *>(container);
     } else {
         if (equals(tag, "toolbar")) {
             KToolBar *bar = qobject_cast<KToolBar *>(containerNode->container);
@@ -763,7 +1145,12 @@ void BuildHelper::processContainerElement(const QDomElement &e, const QString &t
         }
     }
 
-    BuildHelper(m_state, containerNode).build(e);
+    // once a menu is deferred, everything going into it has to wait, to keep the order of the clients
+    if (lazy || !containerNode->pendingBuilds.isEmpty()) {
+        containerNode->deferBuild(e, m_state);
+    } else {
+        BuildHelper(m_state, containerNode).build(e);
+    }
 
     // and re-calculate running values, for better performance
     m_state.currentDefaultMergingIt = parentNode->findIndex(QStringLiteral("<default>"));
@@ -798,6 +1185,212 @@ QWidget *BuildHelper::createContainer(QWidget *parent, int index, const QDomElem
     return res;
 }
 
+UpdateHelper::UpdateHelper(ContainerNode *rootNode, KXMLGUIClient *client, const QStringList &containerTags)
+    : m_rootNode(rootNode)
+    , m_client(client)
+    , m_containerTags(containerTags)
+{
+}
+
+bool UpdateHelper::plan(const QDomElement &oldElement, const QDomElement &newElement)
+{
+    m_updates.clear();
+    m_clientName = oldElement.attribute(QStringLiteral("name"));
+
+    // the client name is used for the merging indices all over the tree
+    if (newElement.attribute(QStringLiteral("name")) != m_clientName) {
+        return false;
+    }
+
+    if (sameElement(oldElement, newElement)) {
+        return true;
+    }
+
+    return planChildren(m_rootNode, oldElement, newElement, true);
+}
+
+void UpdateHelper::apply(BuildState &state)
+{
+    for (const ContainerUpdate &update : std::as_const(m_updates)) {
+        ContainerNode *node = update.node;
+        QWidget *container = node->container;
+
+        const bool updatesEnabled = container->updatesEnabled();
+        container->setUpdatesEnabled(false);
+
+        // same as ContainerNode::destruct(), minus removing the container itself
+        node->destructChildren(update.oldElement, state);
+        node->unplugActions(state);
+
+        node->mergingIndices.removeClientIndices(state.clientName);
+
+        BuildHelper(state, node).build(update.newElement);
+
+        // unplugActions() unregistered the client from the toolbar
+        KToolBar *bar = qobject_cast<KToolBar *>(container);
+        if (bar && !m_client->xmlFile().isEmpty()) {
+            bar->addXMLGUIClient(m_client);
+        }
+
+        container->setUpdatesEnabled(updatesEnabled);
+    }
+    m_updates.clear();
+}
+
+/*
+ * Matches the child elements of oldElement and newElement against each other and plans the
+ * update of every changed child container. Fails if anything else than child containers
+ * differs, in which case the caller has to refill node as a whole.
+ */
+bool UpdateHelper::planChildren(ContainerNode *node, const QDomElement &oldElement, const QDomElement &newElement, bool isRoot)
+{
+    // action properties are applied separately, they don't influence the containers
+    const auto nextElement = [isRoot](QDomElement e) {
+        while (!e.isNull() && isRoot && equals(e.tagName(), "actionproperties")) {
+            e = e.nextSiblingElement();
+        }
+        return e;
+    };
+
+    QList<QWidget *> matchedContainers;
+
+    QDomElement oldChild = nextElement(oldElement.firstChildElement());
+    QDomElement newChild = nextElement(newElement.firstChildElement());
+    for (; !oldChild.isNull() && !newChild.isNull();
+         oldChild = nextElement(oldChild.nextSiblingElement()), newChild = nextElement(newChild.nextSiblingElement())) {
+        const bool unchanged = sameElement(oldChild, newChild);
+        const QString tag = oldChild.tagName();
+        if (!isContainerTag(tag)) {
+            if (!unchanged) {
+                return false;
+            }
+            continue;
+        }
+
+        const QString name = oldChild.attribute(QStringLiteral("name"));
+        if (!equals(newChild.tagName(), tag) || newChild.attribute(QStringLiteral("name")) != name) {
+            return false;
+        }
+
+        // look the node up the same way BuildHelper does, so that we end up with the same match
+        ContainerNode *childNode = node->findContainer(name, tag, &matchedContainers, m_client);
+        if (childNode) {
+            matchedContainers.append(childNode->container);
+        }
+        if (unchanged) {
+            continue;
+        }
+
+        if (!childNode || !isOwned(childNode) || !sameContainerDefinition(oldChild, newChild)) {
+            return false;
+        }
+
+        const qsizetype plannedUpdates = m_updates.size();
+        if (!planChildren(childNode, oldChild, newChild, false)) {
+            // something else than a sub-container changed, refill the whole container
+            m_updates.resize(plannedUpdates);
+            m_updates.append({childNode, oldChild, newChild});
+        }
+    }
+
+    return oldChild.isNull() && newChild.isNull();
+}
+
+bool UpdateHelper::isContainerTag(const QString &tag) const
+{
+    return m_containerTags.contains(tag, Qt::CaseInsensitive);
+}
+
+/*
+ * Returns true if nothing but m_client contributed to node and its sub-containers.
+ * Plugged action lists are not part of the document, so containers with action lists
+ * are treated as foreign, too.
+ */
+bool UpdateHelper::isOwned(const ContainerNode *node) const
+{
+    if (node->client != m_client || !node->container || !node->pendingBuilds.isEmpty()) {
+        return false;
+    }
+
+    for (const ContainerClient *client : node->clients) {
+        if (client->client != m_client || !client->actionLists.isEmpty()) {
+            return false;
+        }
+    }
+
+    for (const MergingIndex &mergingIndex : node->mergingIndices) {
+        if (mergingIndex.clientName != m_clientName) {
+            return false;
+        }
+    }
+
+    return std::all_of(node->children.cbegin(), node->children.cend(), [this](const ContainerNode *child) {
+        return isOwned(child);
+    });
+}
+
+// Comments and processing instructions are ignored by BuildHelper
+static QDomNode nextRelevantNode(QDomNode n)
+{
+    while (!n.isNull() && !n.isElement() && !n.isText()) {
+        n = n.nextSibling();
+    }
+    return n;
+}
+
+bool UpdateHelper::sameElement(const QDomElement &lhs, const QDomElement &rhs)
+{
+    if (lhs.tagName() != rhs.tagName() || !sameAttributes(lhs, rhs)) {
+        return false;
+    }
+
+    QDomNode lhsChild = nextRelevantNode(lhs.firstChild());
+    QDomNode rhsChild = nextRelevantNode(rhs.firstChild());
+    for (; !lhsChild.isNull() && !rhsChild.isNull();
+         lhsChild = nextRelevantNode(lhsChild.nextSibling()), rhsChild = nextRelevantNode(rhsChild.nextSibling())) {
+        if (lhsChild.isElement() != rhsChild.isElement()) {
+            return false;
+        }
+        if (lhsChild.isElement()) {
+            if (!sameElement(lhsChild.toElement(), rhsChild.toElement())) {
+                return false;
+            }
+        } else if (lhsChild.toText().data() != rhsChild.toText().data()) {
+            return false;
+        }
+    }
+
+    return lhsChild.isNull() && rhsChild.isNull();
+}
+
+/*
+ * The container widget itself is created from the attributes and the <text> of its element,
+ * if these change the container has to be recreated.
+ */
+bool UpdateHelper::sameContainerDefinition(const QDomElement &lhs, const QDomElement &rhs)
+{
+    if (!sameAttributes(lhs, rhs)) {
+        return false;
+    }
+
+    const auto nextText = [](QDomElement e) {
+        while (!e.isNull() && !equals(e.tagName(), "text")) {
+            e = e.nextSiblingElement();
+        }
+        return e;
+    };
+
+    QDomElement lhsText = nextText(lhs.firstChildElement());
+    QDomElement rhsText = nextText(rhs.firstChildElement());
+    for (; !lhsText.isNull() && !rhsText.isNull(); lhsText = nextText(lhsText.nextSiblingElement()), rhsText = nextText(rhsText.nextSiblingElement())) {
+        if (!sameElement(lhsText, rhsText)) {
+            return false;
+        }
+    }
+
+    return lhsText.isNull() && rhsText.isNull();
+}
+
 void BuildState::reset()
 {
     clientName.clear();
@@ -805,6 +1398,10 @@ void BuildState::reset()
     actionList.clear();
     guiClient = nullptr;
     clientBuilder = nullptr;
+    containerStates = nullptr;
+    // the next client's builder might be a new one at the same address, or return other tags
+    tagKinds.clear();
+    tagKindsClientBuilder = nullptr;
 
     currentDefaultMergingIt = currentClientMergingIt = MergingIndexList::iterator();
 }
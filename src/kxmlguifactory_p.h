@@ -11,10 +11,13 @@
 #include <QAction>
 #include <QDebug>
 #include <QDomElement>
+#include <QHash>
 #include <QMap>
 #include <QStack>
 #include <QStringList>
 
+#include <utility>
+
 class QWidget;
 class KXMLGUIClient;
 class KXMLGUIBuilder;
@@ -68,13 +71,108 @@ typedef QList<ContainerClient *> ContainerClientList;
 
 struct ContainerNode;
 
+/*
+ * What BuildHelper does with an element, depending on its tag name
+ */
+enum class TagKind : quint8 {
+    Other,
+    Action,
+    Custom,
+    Container,
+    Merge,
+    State,
+};
+typedef QHash<QString, TagKind> TagKindHash;
+
+/*
+ * The state the builder saved into the elements of a client's containers when removing
+ * them (e.g. toolbar positions), by container path, see ContainerNode::statePath().
+ * Only the attributes of the elements are kept. Used instead of writing the state into
+ * a copy of the whole document, see KXMLGUIFactory::removeClient().
+ */
+typedef QHash<QString, QDomElement> ContainerStateHash;
+
+/*
+ * The part of a client's DOM tree that goes into a lazily populated menu. It is
+ * built (together with the state needed for that) when the menu is about to be
+ * shown for the first time, see KXMLGUIFactory::setLazyMenuPopulation().
+ */
+struct PendingBuild {
+    KXMLGUIClient *client;
+    QString clientName;
+    KXMLGUIBuilder *clientBuilder;
+    QStringList clientBuilderCustomTags;
+    QStringList clientBuilderContainerTags;
+    ContainerStateHash *containerStates;
+    QDomElement element;
+};
+
 struct MergingIndex {
     int value; // the actual index value, used as index for plug() or createContainer() calls
     QString mergingName; // the name of the merging index (i.e. the name attribute of the
     // Merge or DefineGroup tag)
     QString clientName; // the name of the client that defined this index
 };
-typedef QList<MergingIndex> MergingIndexList;
+
+/*
+ * The merging indices of a container, in DOM order. Merging names are unique within a
+ * container (redefinitions are ignored), which allows looking them up by name through
+ * a hash instead of comparing all names.
+ *
+ * Indices are only added and removed through insertIndex() and removeClientIndices().
+ * Inserting updates the hash in place, removing rebuilds it on the next lookup. The iterators are only meant for changing the values,
+ * not the names.
+ */
+class MergingIndexList
+{
+public:
+    typedef QList<MergingIndex>::iterator iterator;
+    typedef QList<MergingIndex>::const_iterator const_iterator;
+
+    iterator begin()
+    {
+        return m_indices.begin();
+    }
+    iterator end()
+    {
+        return m_indices.end();
+    }
+    const_iterator begin() const
+    {
+        return m_indices.cbegin();
+    }
+    const_iterator end() const
+    {
+        return m_indices.cend();
+    }
+    const_iterator cbegin() const
+    {
+        return m_indices.cbegin();
+    }
+    const_iterator cend() const
+    {
+        return m_indices.cend();
+    }
+    qsizetype size() const
+    {
+        return m_indices.size();
+    }
+    const QList<MergingIndex> &indices() const
+    {
+        return m_indices;
+    }
+
+    iterator findIndex(const QString &mergingName);
+    void insertIndex(const_iterator before, const MergingIndex &index);
+    void removeClientIndices(const QString &clientName);
+
+private:
+    void updatePositions();
+
+    QList<MergingIndex> m_indices;
+    QHash<QString, qsizetype> m_positions;
+    bool m_positionsValid = true;
+};
 
 /*
  * Here we store detailed information about a container, its clients (client=a guiclient having actions
@@ -128,18 +226,34 @@ struct ContainerNode {
     ContainerClientList clients;
     QList<ContainerNode *> children;
 
+    // children by name attribute and by lowercased tag name (in the order of children),
+    // for findContainer()
+    QHash<QString, QList<ContainerNode *>> childrenByName;
+    QHash<QString, QList<ContainerNode *>> childrenByTagName;
+    // clients by (client, group name), for findChildContainerClient(). An empty group
+    // name maps to the first ContainerClient of the client, whatever its group.
+    QHash<std::pair<KXMLGUIClient *, QString>, ContainerClient *> clientIndex;
+
     int index;
     MergingIndexList mergingIndices;
 
     QString mergingName;
 
+    // The builds deferred until the (menu) container is shown, in the order of the clients
+    QList<PendingBuild> pendingBuilds;
+    QMetaObject::Connection populateConnection;
+
     void clearChildren()
     {
         qDeleteAll(children);
         children.clear();
+        childrenByName.clear();
+        childrenByTagName.clear();
     }
     void removeChild(ContainerNode *child);
     void deleteChild(ContainerNode *child);
+    void indexChild(ContainerNode *child);
+    void unindexChild(ContainerNode *child);
     void removeActions(const QList<QAction *> &actions);
 
     MergingIndexList::iterator findIndex(const QString &name);
@@ -158,12 +272,19 @@ struct ContainerNode {
 
     bool destruct(QDomElement element, BuildState &state);
     void destructChildren(const QDomElement &element, BuildState &state);
-    static QDomElement findElementForChild(const QDomElement &baseElement, ContainerNode *childNode);
+    static QHash<std::pair<QString, QString>, QDomElement> childElements(const QDomElement &baseElement);
+    QString statePath(const QString &childTagName, const QString &childName) const;
     void unplugActions(BuildState &state);
-    void unplugClient(ContainerClient *client);
+    void unplugClients(const ContainerClientList &containerClients);
 
     void reset();
 
+    void deferBuild(const QDomElement &element, BuildState &state);
+    void populate(BuildState &state);
+    void populateAll(BuildState &state);
+    void populateClient(BuildState &state, KXMLGUIClient *client);
+    void populateActionList(BuildState &state);
+
     int calcMergingIndex(const QString &mergingName, MergingIndexList::iterator &it, BuildState &state, bool ignoreDefaultMergingIndex);
 
     void dump(int offset = 0);
@@ -195,8 +316,11 @@ private:
 
     int calcMergingIndex(const QDomElement &element, MergingIndexList::iterator &it, QString &group);
 
-    QStringList customTags;
-    QStringList containerTags;
+    TagKind tagKind(const QString &tag);
+
+    // points either to the tag kinds cached in the state, or to localTagKinds
+    TagKindHash *tagKinds;
+    TagKindHash localTagKinds;
 
     QList<QWidget *> containerList;
 
@@ -209,6 +333,48 @@ private:
     ContainerNode *parentNode;
 };
 
+/*
+ * Used by KXMLGUIFactory::updateClients() to bring the GUI of an already built client
+ * in sync with a changed document without removing and re-adding the whole client.
+ *
+ * plan() compares the document the GUI was built from with the new one, container by
+ * container, and collects the deepest containers whose content changed. It only touches
+ * the node tree when every changed container is owned exclusively by the client (no
+ * other client merged into it) and the container itself (attributes, text) is unchanged,
+ * in which case apply() can refill these containers in place, keeping the container
+ * widgets (and everything else) around.
+ */
+class UpdateHelper
+{
+public:
+    UpdateHelper(ContainerNode *rootNode, KXMLGUIClient *client, const QStringList &containerTags);
+
+    // Returns false if the GUI can't be updated incrementally
+    bool plan(const QDomElement &oldElement, const QDomElement &newElement);
+
+    void apply(BuildState &state);
+
+private:
+    struct ContainerUpdate {
+        ContainerNode *node;
+        QDomElement oldElement;
+        QDomElement newElement;
+    };
+
+    bool planChildren(ContainerNode *node, const QDomElement &oldElement, const QDomElement &newElement, bool isRoot);
+    bool isContainerTag(const QString &tag) const;
+    bool isOwned(const ContainerNode *node) const;
+
+    static bool sameElement(const QDomElement &lhs, const QDomElement &rhs);
+    static bool sameContainerDefinition(const QDomElement &lhs, const QDomElement &rhs);
+
+    ContainerNode *m_rootNode;
+    KXMLGUIClient *m_client;
+    QString m_clientName;
+    QStringList m_containerTags;
+    QList<ContainerUpdate> m_updates;
+};
+
 struct BuildState {
     BuildState()
         : guiClient(nullptr)
@@ -236,6 +402,15 @@ struct BuildState {
     KXMLGUIBuilder *clientBuilder;
     QStringList clientBuilderCustomTags;
     QStringList clientBuilderContainerTags;
+
+    bool lazyMenus = false;
+
+    // where to keep the state of the client's containers, null to write it into the document
+    ContainerStateHash *containerStates = nullptr;
+
+    // tag kinds for builder and clientBuilder, cached across BuildHelpers
+    TagKindHash tagKinds;
+    KXMLGUIBuilder *tagKindsClientBuilder = nullptr;
 };
 
 typedef QStack<BuildState> BuildStateStack;
@@ -168,6 +168,73 @@ static void storeActionProperties(QDomDocument &doc, const ActionPropertiesMap &
     }
 }
 
+// Byte based version of KXMLGUIClient::findVersionNumber(), with the same rules.
+// The keywords are ASCII, so they can be searched for in the UTF-8 data directly.
+static QByteArray findVersionNumber(QByteArrayView xml)
+{
+    const QLatin1String latin1(xml.data(), xml.size());
+    const qsizetype length = xml.size();
+
+    // Jump to the first tag, then to gui..
+    qsizetype pos = xml.indexOf('<');
+    if (pos == -1) {
+        return QByteArray();
+    }
+    pos = latin1.indexOf(QLatin1String("gui"), pos + 1, Qt::CaseInsensitive);
+    if (pos == -1) {
+        return QByteArray(); // Reject
+    }
+    pos += 4; // skip "gui" and the character after it
+
+    while (pos < length) {
+        const qsizetype verpos = latin1.indexOf(QLatin1String("version"), pos, Qt::CaseInsensitive);
+        if (verpos == -1) {
+            return QByteArray(); // Reject
+        }
+        pos = verpos + 7; // strlen("version") is 7
+        while (pos < length && QChar::isSpace(uchar(xml[pos]))) {
+            ++pos;
+        }
+        if (pos >= length || xml[pos++] != '=') {
+            return QByteArray(); // Reject
+        }
+        while (pos < length && QChar::isSpace(uchar(xml[pos]))) {
+            ++pos;
+        }
+        ++pos; // skip the opening quote
+
+        qsizetype endpos = pos;
+        while (endpos < length && xml[endpos] >= '0' && xml[endpos] <= '9') {
+            ++endpos;
+        }
+        if (endpos != pos && endpos < length && xml[endpos] == '"') {
+            return xml.sliced(pos, endpos - pos).toByteArray();
+        }
+        // Try to match a well-formed version..
+        pos = endpos + 1;
+    }
+    return QByteArray();
+}
+
+// Returns the version number of the given ui.rc file. As the version is an attribute of
+// the document element, it is usually found within the first few lines, so only the
+// beginning of the file is read (and not decoded at all), unless that's not enough.
+static QByteArray probeVersionNumber(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QByteArray data = file.read(4096);
+    QByteArray version = findVersionNumber(data);
+    if (version.isEmpty() && !file.atEnd()) {
+        data += file.readAll();
+        version = findVersionNumber(data);
+    }
+    return version;
+}
+
 KXmlGuiVersionHandler::KXmlGuiVersionHandler(const QStringList &files)
 {
     Q_ASSERT(!files.isEmpty());
@@ -183,7 +250,8 @@ KXmlGuiVersionHandler::KXmlGuiVersionHandler(const QStringList &files)
     allDocuments.reserve(files.size());
 
     for (const QString &file : files) {
-        allDocuments.push_back({file, KXMLGUIFactory::readConfigFile(file)});
+        // Only the document we end up using is read completely, see probeVersionNumber()
+        allDocuments.push_back({file, QString()});
     }
 
     auto best = allDocuments.end();
@@ -192,7 +260,7 @@ KXmlGuiVersionHandler::KXmlGuiVersionHandler(const QStringList &files)
     auto docIt = allDocuments.begin();
     const auto docEnd = allDocuments.end();
     for (; docIt != docEnd; ++docIt) {
-        const QString versionStr = KXMLGUIClient::findVersionNumber((*docIt).data);
+        const QByteArray versionStr = probeVersionNumber((*docIt).file);
         if (versionStr.isEmpty()) {
             // qCDebug(DEBUG_KXMLGUI) << "found no version in" << (*docIt).file;
             continue;
@@ -213,11 +281,13 @@ KXmlGuiVersionHandler::KXmlGuiVersionHandler(const QStringList &files)
     }
 
     if (best != docEnd) {
+        (*best).data = KXMLGUIFactory::readConfigFile((*best).file);
         if (best != allDocuments.begin()) {
             auto local = allDocuments.begin();
 
             if ((*local).file.startsWith(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation))) {
                 // load the local document and extract the action properties
+                (*local).data = KXMLGUIFactory::readConfigFile((*local).file);
                 QDomDocument localDocument;
                 localDocument.setContent((*local).data);
 
@@ -269,8 +339,7 @@ KXmlGuiVersionHandler::KXmlGuiVersionHandler(const QStringList &files)
         m_file = (*best).file;
     } else {
         // qCDebug(DEBUG_KXMLGUI) << "returning first one...";
-        const auto &[file, data] = allDocuments.at(0);
-        m_file = file;
-        m_doc = data;
+        m_file = allDocuments.at(0).file;
+        m_doc = KXMLGUIFactory::readConfigFile(m_file);
     }
 }
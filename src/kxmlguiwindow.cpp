@@ -16,6 +16,7 @@
 
 #include "kactioncollection.h"
 #include "kmainwindow_p.h"
+#include "kshortcutregistry_p.h"
 #include <KMessageBox>
 #include <kcommandbar.h>
 #ifdef WITH_QTDBUS
@@ -33,8 +34,10 @@
 #include <QApplication>
 #include <QDomDocument>
 #include <QEvent>
+#include <QHash>
 #include <QList>
 #include <QMenuBar>
+#include <QSet>
 #include <QStatusBar>
 #include <QWidget>
 
@@ -144,6 +147,11 @@ public:
         letDirtySettings = !b;
     }
 
+    KShortcutRegistry *ensureShortcutRegistry();
+    void syncShortcutRegistry();
+    void reportAmbiguousShortcut(const QKeySequence &shortcut, bool interactive);
+    void forgetReportedAmbiguities(const QAction *action);
+
     bool commandBarEnabled = true;
     // Last executed actions in command bar
     QList<QString> lastExecutedActions;
@@ -155,8 +163,135 @@ public:
     KToggleAction *showStatusBarAction;
     QPointer<KEditToolBar> toolBarEditor;
     KXMLGUIFactory *factory;
+    // the shortcuts of the actions of all clients in the GUI, see checkAmbiguousShortcuts()
+    KShortcutRegistry *shortcutRegistry = nullptr;
+    // the ambiguities reported so far, by action: the shortcut and the other action
+    QHash<const QAction *, QSet<std::pair<QKeySequence, const QAction *>>> reportedAmbiguities;
 };
 
+KShortcutRegistry *KXmlGuiWindowPrivate::ensureShortcutRegistry()
+{
+    if (shortcutRegistry) {
+        return shortcutRegistry;
+    }
+
+    auto *window = static_cast<KXmlGuiWindow *>(q);
+    shortcutRegistry = new KShortcutRegistry(window);
+    // not to mistake a new action for an old one at the same address
+    shortcutRegistry->setRemovalHandler([this](QAction *action) {
+        forgetReportedAmbiguities(action);
+    });
+    syncShortcutRegistry();
+
+    KXMLGUIFactory *guiFactory = window->guiFactory();
+    QObject::connect(guiFactory, &KXMLGUIFactory::clientAdded, shortcutRegistry, [this]() {
+        syncShortcutRegistry();
+    });
+    QObject::connect(guiFactory, &KXMLGUIFactory::clientRemoved, shortcutRegistry, [this]() {
+        syncShortcutRegistry();
+    });
+
+    return shortcutRegistry;
+}
+
+void KXmlGuiWindowPrivate::syncShortcutRegistry()
+{
+    auto *window = static_cast<KXmlGuiWindow *>(q);
+
+    // the window's own actions even before createGUI(), and those of all clients in the GUI
+    QSet<KActionCollection *> collections{window->actionCollection()};
+    if (factory) {
+        const QList<KXMLGUIClient *> clients = factory->clients();
+        for (KXMLGUIClient *client : clients) {
+            collections.insert(client->actionCollection());
+        }
+    }
+
+    const QList<KActionCollection *> registered = shortcutRegistry->collections();
+    for (KActionCollection *collection : registered) {
+        if (!collections.contains(collection)) {
+            shortcutRegistry->removeCollection(collection);
+        }
+    }
+    for (KActionCollection *collection : std::as_const(collections)) {
+        shortcutRegistry->addCollection(collection);
+    }
+}
+
+void KXmlGuiWindowPrivate::reportAmbiguousShortcut(const QKeySequence &shortcut, bool interactive)
+{
+    auto *window = static_cast<KXmlGuiWindow *>(q);
+    const QList<QAction *> actions = shortcutRegistry->actions(shortcut);
+    if (actions.size() < 2) {
+        return;
+    }
+
+    QAction *editCutAction = window->actionCollection()->action(QStringLiteral("edit_cut"));
+    QAction *deleteFileAction = window->actionCollection()->action(QStringLiteral("deletefile"));
+    QAction *existingShortcutAction = actions.first();
+    for (qsizetype i = 1; i < actions.size(); ++i) {
+        QAction *action = actions.at(i);
+
+        // There is one exception, if the conflicting shortcut is a non primary shortcut of "edit_cut"
+        // and "deleteFileAction" is the other action since Shift+Delete is used for both in our default code
+        if (editCutAction && deleteFileAction
+            && ((action == editCutAction && existingShortcutAction == deleteFileAction)
+                || (action == deleteFileAction && existingShortcutAction == editCutAction))) {
+            QList<QKeySequence> editCutActionShortcuts = editCutAction->shortcuts();
+            if (editCutActionShortcuts.indexOf(shortcut) > 0) { // alternate shortcut
+                editCutActionShortcuts.removeAll(shortcut);
+                editCutAction->setShortcuts(editCutActionShortcuts);
+                existingShortcutAction = deleteFileAction;
+                continue;
+            }
+        }
+
+        // Each conflict is reported only once, not every time one of the actions changes
+        if (reportedAmbiguities.value(action).contains({shortcut, existingShortcutAction})) {
+            continue;
+        }
+        reportedAmbiguities[action].insert({shortcut, existingShortcutAction});
+        reportedAmbiguities[existingShortcutAction].insert({shortcut, action});
+
+        // If the shortcut is already in use we give a warning, so that hopefully the developer will find it
+        const QString actionName = KLocalizedString::removeAcceleratorMarker(action->text());
+        const QString existingShortcutActionName = KLocalizedString::removeAcceleratorMarker(existingShortcutAction->text());
+        const QList<QAction *> windowActions = window->actionCollection()->actions();
+        if (!interactive || !windowActions.contains(action) || !windowActions.contains(existingShortcutAction)) {
+            // don't interrupt the user with a dialog while they work, nor for conflicts
+            // involving the actions of other clients (e.g. plugins)
+            qCWarning(DEBUG_KXMLGUI) << "The actions" << existingShortcutActionName << "and" << actionName << "use the same shortcut"
+                                     << shortcut.toString(QKeySequence::NativeText) << "- this is most probably a bug";
+            continue;
+        }
+        QString dontShowAgainString = existingShortcutActionName + actionName + shortcut.toString();
+        dontShowAgainString.remove(QLatin1Char('\\'));
+        KMessageBox::information(window,
+                                 i18n("There are two actions (%1, %2) that want to use the same shortcut (%3). This is most probably a bug. "
+                                      "Please report it in <a href='https://bugs.kde.org'>bugs.kde.org</a>",
+                                      existingShortcutActionName,
+                                      actionName,
+                                      shortcut.toString(QKeySequence::NativeText)),
+                                 i18n("Ambiguous Shortcuts"),
+                                 dontShowAgainString,
+                                 KMessageBox::Notify | KMessageBox::AllowLink);
+    }
+}
+
+void KXmlGuiWindowPrivate::forgetReportedAmbiguities(const QAction *action)
+{
+    const QSet<std::pair<QKeySequence, const QAction *>> reported = reportedAmbiguities.take(action);
+    for (const auto &[shortcut, otherAction] : reported) {
+        const auto it = reportedAmbiguities.find(otherAction);
+        if (it != reportedAmbiguities.end()) {
+            it->remove({shortcut, action});
+            if (it->isEmpty()) {
+                reportedAmbiguities.erase(it);
+            }
+        }
+    }
+}
+
 KXmlGuiWindow::KXmlGuiWindow(QWidget *parent, Qt::WindowFlags flags)
     : KMainWindow(*new KXmlGuiWindowPrivate, parent, flags)
     , KXMLGUIBuilder(this)
@@ -317,10 +452,10 @@ void KXmlGuiWindow::configureToolbars()
 
 void KXmlGuiWindow::saveNewToolbarConfig()
 {
-    // createGUI(xmlFile()); // this loses any plugged-in guiclients, so we use remove+add instead.
+    // createGUI(xmlFile()); // this loses any plugged-in guiclients, so we use updateClients instead,
+    // which falls back to remove+add when needed.
 
-    guiFactory()->removeClient(this);
-    guiFactory()->addClient(this);
+    guiFactory()->updateClients({this});
 
     KConfigGroup cg(KSharedConfig::openConfig(), QString());
     applyMainWindowSettings(cg);
@@ -534,59 +669,38 @@ void KXmlGuiWindow::applyMainWindowSettings(const KConfigGroup &config)
 
 void KXmlGuiWindow::checkAmbiguousShortcuts()
 {
-    QMap<QString, QAction *> shortcuts;
-    QAction *editCutAction = actionCollection()->action(QStringLiteral("edit_cut"));
-    QAction *deleteFileAction = actionCollection()->action(QStringLiteral("deletefile"));
-    const auto actions = actionCollection()->actions();
-    for (QAction *action : actions) {
-        if (action->isEnabled()) {
-            const auto actionShortcuts = action->shortcuts();
-            for (const QKeySequence &shortcut : actionShortcuts) {
-                if (shortcut.isEmpty()) {
-                    continue;
-                }
-                const QString portableShortcutText = shortcut.toString();
-                const QAction *existingShortcutAction = shortcuts.value(portableShortcutText);
-                if (existingShortcutAction) {
-                    // If the shortcut is already in use we give a warning, so that hopefully the developer will find it
-                    // There is one exception, if the conflicting shortcut is a non primary shortcut of "edit_cut"
-                    // and "deleteFileAction" is the other action since Shift+Delete is used for both in our default code
-                    bool showWarning = true;
-                    if ((action == editCutAction && existingShortcutAction == deleteFileAction)
-                        || (action == deleteFileAction && existingShortcutAction == editCutAction)) {
-                        QList<QKeySequence> editCutActionShortcuts = editCutAction->shortcuts();
-                        if (editCutActionShortcuts.indexOf(shortcut) > 0) // alternate shortcut
-                        {
-                            editCutActionShortcuts.removeAll(shortcut);
-                            editCutAction->setShortcuts(editCutActionShortcuts);
-
-                            showWarning = false;
-                        }
-                    }
-
-                    if (showWarning) {
-                        const QString actionName = KLocalizedString::removeAcceleratorMarker(action->text());
-                        const QString existingShortcutActionName = KLocalizedString::removeAcceleratorMarker(existingShortcutAction->text());
-                        QString dontShowAgainString = existingShortcutActionName + actionName + shortcut.toString();
-                        dontShowAgainString.remove(QLatin1Char('\\'));
-                        KMessageBox::information(this,
-                                                 i18n("There are two actions (%1, %2) that want to use the same shortcut (%3). This is most probably a bug. "
-                                                      "Please report it in <a href='https://bugs.kde.org'>bugs.kde.org</a>",
-                                                      existingShortcutActionName,
-                                                      actionName,
-                                                      shortcut.toString(QKeySequence::NativeText)),
-                                                 i18n("Ambiguous Shortcuts"),
-                                                 dontShowAgainString,
-                                                 KMessageBox::Notify | KMessageBox::AllowLink);
-                    }
-                } else {
-                    shortcuts.insert(portableShortcutText, action);
-                }
-            }
+    Q_D(KXmlGuiWindow);
+    KShortcutRegistry *registry = d->ensureShortcutRegistry();
+    d->syncShortcutRegistry();
+
+    // From now on, shortcuts becoming ambiguous are reported (as warnings) as it happens,
+    // e.g. when a plugin adds conflicting actions
+    registry->setAmbiguityHandler([d](const QList<QKeySequence> &shortcuts) {
+        for (const QKeySequence &shortcut : shortcuts) {
+            d->reportAmbiguousShortcut(shortcut, false);
         }
+    });
+
+    // all of them are reported right now
+    registry->takeNewAmbiguities();
+    const QList<QKeySequence> shortcuts = registry->ambiguousShortcuts();
+    for (const QKeySequence &shortcut : shortcuts) {
+        d->reportAmbiguousShortcut(shortcut, true);
     }
 }
 
+QList<QKeySequence> KXmlGuiWindow::ambiguousShortcuts() const
+{
+    Q_D(const KXmlGuiWindow);
+    return const_cast<KXmlGuiWindowPrivate *>(d)->ensureShortcutRegistry()->ambiguousShortcuts();
+}
+
+QList<QAction *> KXmlGuiWindow::actionsForShortcut(const QKeySequence &shortcut) const
+{
+    Q_D(const KXmlGuiWindow);
+    return const_cast<KXmlGuiWindowPrivate *>(d)->ensureShortcutRegistry()->actions(shortcut);
+}
+
 void KXmlGuiWindow::setCommandBarEnabled(bool showCommandBar)
 {
     /*
@@ -19,6 +19,7 @@
 #include "kxmlguiclient.h"
 
 class KMenu;
+class QKeySequence;
 class KXMLGUIFactory;
 class KConfig;
 class KConfigGroup;
@@ -516,6 +517,26 @@ public Q_SLOTS:
      */
     void setToolBarVisible(const QString &name, bool visible);
 
+    /*!
+     * \brief Returns the shortcuts which are used by more than one enabled and
+     * visible action of this window and of the clients in its GUI.
+     *
+     * Actions whose QAction::shortcutContext() is limited to a widget are left out.
+     *
+     * \sa actionsForShortcut(), checkAmbiguousShortcuts()
+     * \since 6.30
+     */
+    QList<QKeySequence> ambiguousShortcuts() const;
+
+    /*!
+     * \brief Returns the enabled and visible actions of this window and of the
+     * clients in its GUI which use \a shortcut.
+     *
+     * \sa ambiguousShortcuts()
+     * \since 6.30
+     */
+    QList<QAction *> actionsForShortcut(const QKeySequence &shortcut) const;
+
 protected:
     /*!
      * Reimplemented to return the \a event QEvent::Polish in order to adjust the object name
@@ -528,8 +549,17 @@ protected:
     /*!
      * \brief Checks if there are actions using the same shortcut.
      *
-     * This is called automatically from createGUI().
+     * This is called automatically from createGUI(). Afterwards, shortcuts which
+     * become ambiguous (e.g. because a plugin added an action or because a shortcut
+     * was changed) are reported as well, as warnings in the debug output.
+     * Each conflict between two actions is reported only once.
+     *
+     * Only enabled and visible actions of this window and of the clients in its GUI
+     * are taken into account, unless their QAction::shortcutContext() is limited to
+     * a widget. Only conflicts between the actions of this window are shown to the
+     * user, the others are reported in the debug output.
      *
+     * \sa ambiguousShortcuts()
      * \since 5.30
      */
     void checkAmbiguousShortcuts();